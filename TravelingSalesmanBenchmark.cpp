@@ -0,0 +1,721 @@
+#include "TravelingSalesmanSolver.h"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <random>
+#include <iterator>
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Kinds of random instance the benchmark can generate
+enum InstanceType { UNIFORM_INSTANCE, CLUSTERED_INSTANCE, SYMMETRIC_INSTANCE, ASYMMETRIC_INSTANCE, NEGATIVE_INSTANCE };
+const char *const INSTANCE_TYPE_NAMES[] = { "uniform", "clustered", "symmetric", "asymmetric", "negative" };
+const int COORDINATE_RANGE = 1000; // Euclidean cities are placed in a COORDINATE_RANGE x COORDINATE_RANGE square
+const int CLUSTER_SPREAD = 40; // Standard deviation of a clustered city's distance from its cluster centre, per axis
+const int MAXIMUM_EDGE_COST = 100; // Matrix instances draw every edge cost from 1..MAXIMUM_EDGE_COST
+const int CROSS_CHECK_MAX_CITIES = 16; // Largest branch-and-bound run that is solved again by the Held-Karp engine (a few ms at 16 cities)
+const double SLOWDOWN_NOISE_FLOOR_MS = 5.0; // Runs faster than this in the baseline are too noisy to be reported as slowdowns
+
+// Settings of a benchmark session, read from the command line
+struct BenchmarkOptions {
+    std::vector<int> sizes;
+    std::vector<int> threadCounts;
+    std::vector<InstanceType> instanceTypes;
+    std::vector<BranchingStrategy> branchingStrategies;
+    int numberOfSeeds;
+    unsigned firstSeed;
+    std::string outputPath; // Results are written to the console when empty
+    std::string baselinePath; // Results of an earlier build to compare against; empty for no comparison
+    double tolerance; // Fraction by which a run may be slower than its baseline before it is reported
+};
+
+// One row of the results: the instance, the solver settings and what was measured
+struct BenchmarkRun {
+    std::string instanceType;
+    int cities;
+    unsigned seed;
+    int threads;
+    std::string bound;
+    std::string engine;
+    std::string search;
+    std::string expansion;
+    std::string branching;
+    int dominanceCacheMegabytes;
+    int warmStart;
+    double routeCost;
+    long long nodesExpanded;
+    double nodesPerSecond;
+    double firstRouteMilliseconds;
+    double bestRouteMilliseconds;
+    double proofMilliseconds;
+    int peakQueueSize;
+    long peakResidentKilobytes;
+};
+
+const char *const RESULT_COLUMNS = "type,cities,seed,threads,bound,engine,search,expansion,branching,dominance_cache_mb,warm_start,route_cost,nodes_expanded,nodes_per_second,"
+    "first_route_ms,best_route_ms,proof_ms,peak_queue,peak_rss_kb";
+
+bool readInBenchmarkOptions(int argc, char* argv[], BenchmarkOptions &options, ProgramVariables &programVariables);
+bool parseIntegerList(const char *text, std::vector<int> &values);
+void generateInstance(ProgramVariables &programVariables, InstanceType type, int numberOfCities, unsigned seed);
+double randomUnit(std::mt19937 &generator);
+BenchmarkRun runBenchmark(TravelingSalesmanSolver &solver, InstanceType type, int numberOfCities, unsigned seed, int threads, BranchingStrategy branching);
+bool crossCheckWithHeldKarp(TravelingSalesmanSolver &referenceSolver, InstanceType type, const BenchmarkRun &run);
+void resetPeakResidentMemory();
+long peakResidentKilobytes();
+std::string formatRun(const BenchmarkRun &run);
+std::string runKey(const BenchmarkRun &run);
+bool parseRun(const std::string &line, BenchmarkRun &run);
+bool compareWithBaseline(const std::vector<BenchmarkRun> &runs, const BenchmarkOptions &options);
+void printBranchingSummary(const std::vector<BenchmarkRun> &runs, const BenchmarkOptions &options);
+
+/*
+    Benchmark driver. Every combination of instance type, number of cities, seed, thread count and branching strategy is generated, solved 
+    to optimality and written out as one CSV row. The rows of two builds can be diffed directly, or checked with --compare. Small 
+    branch-and-bound runs are also checked against the Held-Karp engine (see crossCheckWithHeldKarp()).
+*/
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    TravelingSalesmanSolver solver; // Reused for every run; the solver options are read into it
+    if (!readInBenchmarkOptions(argc, argv, options, solver.programVariables))
+    {
+        return 1;
+    }
+    TravelingSalesmanSolver referenceSolver;
+    referenceSolver.programVariables.engine = HELD_KARP_ENGINE;
+    referenceSolver.programVariables.logLevel = LOG_SILENT;
+    int crossCheckFailures = 0;
+
+    std::ofstream outputFile;
+    if (!options.outputPath.empty())
+    {
+        outputFile.open(options.outputPath.c_str());
+        if (!outputFile)
+        {
+            std::cout << "Could not open '" << options.outputPath << "' for writing." << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &output = options.outputPath.empty() ? std::cout : outputFile;
+
+    output << RESULT_COLUMNS << std::endl;
+    std::vector<BenchmarkRun> runs;
+    for (size_t t = 0; t < options.instanceTypes.size(); t++)
+    {
+        for (size_t s = 0; s < options.sizes.size(); s++)
+        {
+            for (int seed = 0; seed < options.numberOfSeeds; seed++)
+            {
+                for (size_t c = 0; c < options.threadCounts.size(); c++)
+                {
+                    for (size_t b = 0; b < options.branchingStrategies.size(); b++)
+                    {
+                        BenchmarkRun run = runBenchmark(solver, options.instanceTypes[t], options.sizes[s], options.firstSeed + seed, options.threadCounts[c], 
+                            options.branchingStrategies[b]);
+                        output << formatRun(run) << std::endl; // Flushed per row, so a run that never finishes still leaves the earlier rows behind
+                        if (!options.outputPath.empty())
+                        {
+                            std::cout << run.instanceType << " " << run.cities << " cities, seed " << run.seed << ", " << run.threads << " thread(s), " 
+                                << run.branching << " branching: cost " << run.routeCost << ", " << run.nodesExpanded << " nodes, " << run.proofMilliseconds << " ms" << std::endl;
+                        }
+                        runs.push_back(run);
+                        crossCheckFailures += crossCheckWithHeldKarp(referenceSolver, options.instanceTypes[t], run) ? 0 : 1;
+                    }
+                }
+            }
+        }
+    }
+
+    printBranchingSummary(runs, options);
+    if (crossCheckFailures > 0)
+    {
+        std::cout << crossCheckFailures << " run(s) disagreed with the Held-Karp engine." << std::endl;
+    }
+    if (!options.baselinePath.empty() && !compareWithBaseline(runs, options))
+    {
+        return 1;
+    }
+    return crossCheckFailures == 0 ? 0 : 1;
+}
+
+/*
+    Reads the command line switches:
+        --sizes N,N,...              numbers of cities to benchmark (default 8,10,12); above MAX_CITIES only with --engine lk
+        --threads N,N,...            worker thread counts to run each instance with (default 1 and one per hardware core)
+        --types T,T,...              any of uniform, clustered, symmetric, asymmetric, negative (default all five)
+        --seeds N                    instances generated per type and size (default 3)
+        --first-seed N               seed of the first instance (default 1); instance k uses first-seed + k
+        --bound simple|onetree       lower bound used by the solver (default simple)
+        --engine auto|bnb|dp|lk      engine used by the solver (default bnb, so the search itself is measured at every size; auto picks one per 
+                                     instance, see solveLoadedInstance()); lk runs are not proven optimal
+        --search bestfirst|dfs|hybrid order of the branch-and-bound search (default bestfirst, see shouldSearchDepthFirst())
+        --memory-budget MB           size of the queues at which the hybrid search turns depth-first (default 1024)
+        --expansion edge|row         how the best-first search expands a popped node (default edge, see expandRow())
+        --dominance-cache MB         size of the table that drops dominated nodes (default 0, none)
+        --branching S,S,...          branching strategies to run each instance with: any of rowmajor, constrained, penalty, strong
+                                     (default rowmajor, see chooseBranchingEdge()); with more than one, the nodes expanded by each are summed up at the end
+                                     and the engine is bnb (auto is turned into bnb, dp and lk are rejected)
+        --no-warm-start              start every search without a heuristic route
+        --output FILE                write the CSV rows to FILE and a progress line per run to the console
+        --compare FILE               compare against the CSV rows of an earlier build (see compareWithBaseline())
+        --tolerance PERCENT          slowdown allowed by --compare (default 10)
+    Returns false (after printing the reason) if a switch has an invalid value.
+*/
+bool readInBenchmarkOptions(int argc, char* argv[], BenchmarkOptions &options, ProgramVariables &programVariables)
+{
+    int hardwareThreads = std::thread::hardware_concurrency();
+    options.sizes = { 8, 10, 12 };
+    options.threadCounts.push_back(1);
+    if (hardwareThreads > 1)
+    {
+        options.threadCounts.push_back(hardwareThreads);
+    }
+    options.instanceTypes = { UNIFORM_INSTANCE, CLUSTERED_INSTANCE, SYMMETRIC_INSTANCE, ASYMMETRIC_INSTANCE, NEGATIVE_INSTANCE };
+    options.branchingStrategies = { ROW_MAJOR_BRANCHING };
+    options.numberOfSeeds = 3;
+    options.firstSeed = 1;
+    options.tolerance = 0.10;
+    programVariables.engine = BRANCH_AND_BOUND_ENGINE;
+    programVariables.logLevel = LOG_SILENT;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--no-warm-start") == 0)
+        {
+            programVariables.warmStart = false;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            std::cout << "Missing value for '" << argv[i] << "'." << std::endl;
+            return false;
+        }
+
+        const char *value = argv[++i];
+        bool valid = true;
+        if (std::strcmp(argv[i - 1], "--sizes") == 0)
+        {
+            valid = parseIntegerList(value, options.sizes);
+            for (size_t s = 0; valid && s < options.sizes.size(); s++)
+            {
+                valid = options.sizes[s] >= 3; // Checked against MAX_CITIES below, once the engine is known
+            }
+        }
+        else if (std::strcmp(argv[i - 1], "--threads") == 0)
+        {
+            valid = parseIntegerList(value, options.threadCounts);
+            for (size_t c = 0; valid && c < options.threadCounts.size(); c++)
+            {
+                valid = options.threadCounts[c] > 0;
+            }
+        }
+        else if (std::strcmp(argv[i - 1], "--types") == 0)
+        {
+            options.instanceTypes.clear();
+            std::stringstream names(value);
+            std::string name;
+            while (valid && std::getline(names, name, ','))
+            {
+                const char *const *found = std::find_if(INSTANCE_TYPE_NAMES, std::end(INSTANCE_TYPE_NAMES), [&name](const char *typeName) { return name == typeName; });
+                valid = found != std::end(INSTANCE_TYPE_NAMES);
+                options.instanceTypes.push_back(InstanceType(found - INSTANCE_TYPE_NAMES));
+            }
+            valid = valid && !options.instanceTypes.empty();
+        }
+        else if (std::strcmp(argv[i - 1], "--seeds") == 0)
+        {
+            options.numberOfSeeds = std::atoi(value);
+            valid = options.numberOfSeeds > 0;
+        }
+        else if (std::strcmp(argv[i - 1], "--first-seed") == 0)
+        {
+            options.firstSeed = unsigned(std::strtoul(value, NULL, 10));
+        }
+        else if (std::strcmp(argv[i - 1], "--bound") == 0)
+        {
+            valid = std::strcmp(value, "simple") == 0 || std::strcmp(value, "onetree") == 0;
+            programVariables.boundType = std::strcmp(value, "onetree") == 0 ? ONE_TREE_BOUND : SIMPLE_BOUND;
+        }
+        else if (std::strcmp(argv[i - 1], "--engine") == 0)
+        {
+            const char *const *found = std::find_if(ENGINE_NAMES, std::end(ENGINE_NAMES), [value](const char *engineName) { return std::strcmp(value, engineName) == 0; });
+            valid = found != std::end(ENGINE_NAMES);
+            programVariables.engine = valid ? SolverEngine(found - ENGINE_NAMES) : AUTO_ENGINE;
+        }
+        else if (std::strcmp(argv[i - 1], "--search") == 0)
+        {
+            valid = std::strcmp(value, "bestfirst") == 0 || std::strcmp(value, "dfs") == 0 || std::strcmp(value, "hybrid") == 0;
+            programVariables.searchMode = std::strcmp(value, "dfs") == 0 ? DEPTH_FIRST_SEARCH : std::strcmp(value, "hybrid") == 0 ? HYBRID_SEARCH : BEST_FIRST_SEARCH;
+        }
+        else if (std::strcmp(argv[i - 1], "--branching") == 0)
+        {
+            options.branchingStrategies.clear();
+            std::stringstream names(value);
+            std::string name;
+            while (valid && std::getline(names, name, ','))
+            {
+                const char *const *found = std::find_if(BRANCHING_STRATEGY_NAMES, BRANCHING_STRATEGY_NAMES + NUMBER_OF_BRANCHING_STRATEGIES, 
+                    [&name](const char *strategyName) { return name == strategyName; });
+                valid = found != BRANCHING_STRATEGY_NAMES + NUMBER_OF_BRANCHING_STRATEGIES;
+                options.branchingStrategies.push_back(BranchingStrategy(found - BRANCHING_STRATEGY_NAMES));
+            }
+            valid = valid && !options.branchingStrategies.empty();
+        }
+        else if (std::strcmp(argv[i - 1], "--memory-budget") == 0)
+        {
+            programVariables.memoryBudget = std::atoll(value) << 20;
+            valid = programVariables.memoryBudget > 0;
+        }
+        else if (std::strcmp(argv[i - 1], "--expansion") == 0)
+        {
+            valid = std::strcmp(value, "edge") == 0 || std::strcmp(value, "row") == 0;
+            programVariables.expansionMode = std::strcmp(value, "row") == 0 ? ROW_EXPANSION : EDGE_EXPANSION;
+        }
+        else if (std::strcmp(argv[i - 1], "--dominance-cache") == 0)
+        {
+            programVariables.dominanceCacheBytes = std::atoll(value) << 20;
+            valid = programVariables.dominanceCacheBytes > 0 || std::strcmp(value, "0") == 0;
+        }
+        else if (std::strcmp(argv[i - 1], "--output") == 0)
+        {
+            options.outputPath = value;
+        }
+        else if (std::strcmp(argv[i - 1], "--compare") == 0)
+        {
+            options.baselinePath = value;
+        }
+        else if (std::strcmp(argv[i - 1], "--tolerance") == 0)
+        {
+            options.tolerance = std::atof(value) / 100.0;
+            valid = options.tolerance >= 0;
+        }
+        else
+        {
+            std::cout << "Unknown switch '" << argv[i - 1] << "'." << std::endl;
+            return false;
+        }
+
+        if (!valid)
+        {
+            std::cout << "Invalid value '" << value << "' for '" << argv[i - 1] << "'." << std::endl;
+            return false;
+        }
+    }
+
+    for (size_t s = 0; s < options.sizes.size(); s++)
+    {
+        if (options.sizes[s] > MAX_CITIES && programVariables.engine != LIN_KERNIGHAN_ENGINE)
+        {
+            std::cout << "Sizes above " << MAX_CITIES << " cities need --engine lk." << std::endl;
+            return false;
+        }
+    }
+    if (options.branchingStrategies.size() > 1 && programVariables.engine != BRANCH_AND_BOUND_ENGINE)
+    {
+        if (programVariables.engine != AUTO_ENGINE)
+        {
+            std::cout << "More than one --branching strategy can only be compared with --engine bnb." << std::endl;
+            return false;
+        }
+        programVariables.engine = BRANCH_AND_BOUND_ENGINE; // auto would hand the small sizes to the Held-Karp engine, which does not branch
+    }
+    return true;
+}
+
+/*
+    Parses a comma separated list of integers such as "8,10,12". Returns false if the list is empty or holds anything but integers.
+*/
+bool parseIntegerList(const char *text, std::vector<int> &values)
+{
+    values.clear();
+    std::stringstream items(text);
+    std::string item;
+
+    while (std::getline(items, item, ','))
+    {
+        char *end;
+        long value = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0')
+        {
+            return false;
+        }
+        values.push_back(int(value));
+    }
+
+    return !values.empty();
+}
+
+/*
+    Puts a random instance into a solver's programVariables, ready for solveLoadedInstance(). The same type, size and seed always give the same instance:
+    only the raw output of std::mt19937 is used (the standard library's distributions differ between implementations), so the instances are
+    the same on every platform and compiler.
+        uniform      cities placed uniformly at random in the square, EUC_2D distances
+        clustered    cities scattered around numberOfCities / 8 (at least 2) random centres, EUC_2D distances
+        symmetric    every edge cost drawn uniformly from 1..MAXIMUM_EDGE_COST
+        asymmetric   every directed cost drawn independently. The solver treats edges as undirected and charges the upper triangle
+                     (see symmetrizeAdjacencyMatrix()), so these runs measure the same kind of search as symmetric ones on a different
+                     draw; the generator is here so the benchmark already covers asymmetric input once the solver handles it
+        negative     like symmetric, but every cost drawn from -MAXIMUM_EDGE_COST / 2..MAXIMUM_EDGE_COST / 2, so the bounds are exercised 
+                     with negative edges and negative totals
+*/
+void generateInstance(ProgramVariables &programVariables, InstanceType type, int numberOfCities, unsigned seed)
+{
+    std::seed_seq seeds = { seed, unsigned(numberOfCities), unsigned(type) };
+    std::mt19937 generator(seeds);
+    programVariables.numberOfCitiesToVisit = numberOfCities;
+
+    if (type == UNIFORM_INSTANCE || type == CLUSTERED_INSTANCE)
+    {
+        programVariables.edgeWeightType = EUC_2D_WEIGHTS;
+        std::vector<std::pair<double, double> > centres;
+        int numberOfClusters = std::max(2, numberOfCities / 8);
+        for (int c = 0; type == CLUSTERED_INSTANCE && c < numberOfClusters; c++)
+        {
+            centres.push_back(std::make_pair(randomUnit(generator) * COORDINATE_RANGE, randomUnit(generator) * COORDINATE_RANGE));
+        }
+
+        for (int city = 0; city < numberOfCities; city++)
+        {
+            if (type == UNIFORM_INSTANCE)
+            {
+                programVariables.cityCoordinates.push_back(std::make_pair(randomUnit(generator) * COORDINATE_RANGE, randomUnit(generator) * COORDINATE_RANGE));
+                continue;
+            }
+
+            // Box-Muller transform: two uniform draws give two independent normally distributed offsets
+            const std::pair<double, double> &centre = centres[generator() % numberOfClusters];
+            double radius = CLUSTER_SPREAD * std::sqrt(-2.0 * std::log(1.0 - randomUnit(generator)));
+            double angle = 2.0 * 3.14159265358979 * randomUnit(generator);
+            double x = std::min(double(COORDINATE_RANGE), std::max(0.0, centre.first + radius * std::cos(angle)));
+            double y = std::min(double(COORDINATE_RANGE), std::max(0.0, centre.second + radius * std::sin(angle)));
+            programVariables.cityCoordinates.push_back(std::make_pair(x, y));
+        }
+        return;
+    }
+
+    programVariables.adjacencyMatrix.assign(numberOfCities);
+    for (int row = 0; row < numberOfCities; row++)
+    {
+        for (int column = type == ASYMMETRIC_INSTANCE ? 0 : row + 1; column < numberOfCities; column++)
+        {
+            if (column != row)
+            {
+                int cost = type == NEGATIVE_INSTANCE ? int(generator() % (MAXIMUM_EDGE_COST + 1)) - MAXIMUM_EDGE_COST / 2 : 1 + int(generator() % MAXIMUM_EDGE_COST);
+                programVariables.adjacencyMatrix[row][column] = cost;
+                if (type != ASYMMETRIC_INSTANCE)
+                {
+                    programVariables.adjacencyMatrix[column][row] = cost;
+                }
+            }
+        }
+    }
+}
+
+/*
+    Uniformly distributed number in [0, 1) built from one draw of the generator.
+*/
+double randomUnit(std::mt19937 &generator)
+{
+    return generator() / 4294967296.0;
+}
+
+/*
+    Generates one instance, solves it with the given number of threads and branching strategy and collects the measurements. Times are measured from the start of
+    solveLoadedInstance(), so the time to the first route includes the root bound and the starting route heuristic.
+*/
+BenchmarkRun runBenchmark(TravelingSalesmanSolver &solver, InstanceType type, int numberOfCities, unsigned seed, int threads, BranchingStrategy branching)
+{
+    ProgramVariables &programVariables = solver.programVariables;
+    solver.resetProgramVariables();
+    programVariables.numberOfThreads = threads;
+    programVariables.branchingStrategy = branching;
+    generateInstance(programVariables, type, numberOfCities, seed);
+    resetPeakResidentMemory();
+    solver.solveLoadedInstance();
+
+    BenchmarkRun run;
+    run.instanceType = INSTANCE_TYPE_NAMES[type];
+    run.cities = numberOfCities;
+    run.seed = seed;
+    run.threads = threads;
+    run.bound = programVariables.boundType == ONE_TREE_BOUND ? "onetree" : "simple";
+    run.engine = ENGINE_NAMES[programVariables.engineUsed];
+    const char *const searchNames[] = { "bestfirst", "dfs", "hybrid" };
+    run.search = searchNames[programVariables.searchMode];
+    run.expansion = EXPANSION_MODE_NAMES[solver.expansionModeUsed()];
+    run.branching = BRANCHING_STRATEGY_NAMES[programVariables.branchingStrategy];
+    run.dominanceCacheMegabytes = int(programVariables.dominanceCacheBytes >> 20);
+    run.warmStart = programVariables.warmStart ? 1 : 0;
+    run.routeCost = programVariables.bestRouteCost.load();
+    run.nodesExpanded = programVariables.nodesExpanded.load();
+    run.nodesPerSecond = programVariables.searchMilliseconds > 0 ? run.nodesExpanded * 1000.0 / programVariables.searchMilliseconds : 0;
+    run.firstRouteMilliseconds = programVariables.firstRouteMilliseconds;
+    run.bestRouteMilliseconds = programVariables.bestRouteMilliseconds;
+    run.proofMilliseconds = programVariables.solveMilliseconds;
+    run.peakQueueSize = programVariables.peakOutstandingNodes.load();
+    run.peakResidentKilobytes = peakResidentKilobytes();
+    return run;
+}
+
+/*
+    Solves the instance of a branch-and-bound run again with the Held-Karp engine, which needs no lower bound, and reports the run if the two 
+    route costs differ: a bound that overestimates somewhere prunes the optimum away and still ends with a plausible route. Runs of other 
+    engines and runs above CROSS_CHECK_MAX_CITIES are not checked. Returns false if the costs differ.
+*/
+bool crossCheckWithHeldKarp(TravelingSalesmanSolver &referenceSolver, InstanceType type, const BenchmarkRun &run)
+{
+    if (run.engine != "bnb" || run.cities > CROSS_CHECK_MAX_CITIES)
+    {
+        return true;
+    }
+
+    referenceSolver.resetProgramVariables();
+    generateInstance(referenceSolver.programVariables, type, run.cities, run.seed);
+    referenceSolver.solveLoadedInstance();
+    double optimalCost = referenceSolver.programVariables.bestRouteCost.load();
+    if (optimalCost == run.routeCost)
+    {
+        return true;
+    }
+    std::cout << run.instanceType << " " << run.cities << " cities, seed " << run.seed << ", " << run.threads << " thread(s), " << run.branching 
+        << " branching: branch-and-bound found " << run.routeCost << ", the Held-Karp engine " << optimalCost << std::endl;
+    return false;
+}
+
+/*
+    Lowers the peak resident memory recorded by the OS to the current resident memory, so that peakResidentKilobytes() measures a single run
+    rather than the whole benchmark session. Only Linux offers this (through /proc/self/clear_refs); elsewhere the peak covers every run so far.
+    glibc keeps the memory freed by the previous run's arena and queues mapped, so it is handed back to the OS first.
+*/
+void resetPeakResidentMemory()
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    FILE *clearRefs = std::fopen("/proc/self/clear_refs", "w");
+    if (clearRefs != NULL)
+    {
+        std::fputs("5", clearRefs);
+        std::fclose(clearRefs);
+    }
+#endif
+}
+
+/*
+    Peak resident memory of the process in kilobytes, or -1 if it cannot be measured.
+*/
+long peakResidentKilobytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return long(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#else
+#ifdef __linux__
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (status != NULL)
+    {
+        char line[256];
+        long kilobytes = -1;
+        while (std::fgets(line, sizeof(line), status) != NULL)
+        {
+            if (std::strncmp(line, "VmHWM:", 6) == 0)
+            {
+                kilobytes = std::atol(line + 6);
+                break;
+            }
+        }
+        std::fclose(status);
+        if (kilobytes >= 0)
+        {
+            return kilobytes;
+        }
+    }
+#endif
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+#ifdef __APPLE__
+    return long(usage.ru_maxrss / 1024); // Reported in bytes on macOS, kilobytes elsewhere
+#else
+    return long(usage.ru_maxrss);
+#endif
+#endif
+}
+
+/*
+    Formats a run as a CSV row, in the order of RESULT_COLUMNS.
+*/
+std::string formatRun(const BenchmarkRun &run)
+{
+    std::ostringstream row;
+    row << std::fixed << std::setprecision(3);
+    row << run.instanceType << "," << run.cities << "," << run.seed << "," << run.threads << "," << run.bound << "," << run.engine << "," << run.search << "," << run.expansion << "," 
+        << run.branching << "," << run.dominanceCacheMegabytes << "," << run.warmStart << "," << std::setprecision(0) << run.routeCost << "," << run.nodesExpanded << "," << run.nodesPerSecond << "," << std::setprecision(3)
+        << run.firstRouteMilliseconds << "," << run.bestRouteMilliseconds << "," << run.proofMilliseconds << "," << run.peakQueueSize << ","
+        << run.peakResidentKilobytes;
+    return row.str();
+}
+
+/*
+    Identifies a run across builds: the instance and the solver settings, without any of the measurements.
+*/
+std::string runKey(const BenchmarkRun &run)
+{
+    std::ostringstream key;
+    key << run.instanceType << "," << run.cities << "," << run.seed << "," << run.threads << "," << run.bound << "," << run.engine << "," << run.search << "," << run.expansion << "," 
+        << run.branching << "," << run.dominanceCacheMegabytes << "," << run.warmStart;
+    return key.str();
+}
+
+/*
+    Reads a CSV row written by formatRun(). Returns false for the header and for malformed rows.
+*/
+bool parseRun(const std::string &line, BenchmarkRun &run)
+{
+    std::stringstream fields(line);
+    std::string type, bound, engine, search, expansion, branching;
+    char separator;
+
+    if (!std::getline(fields, type, ',') || type == "type")
+    {
+        return false;
+    }
+    fields >> run.cities >> separator >> run.seed >> separator >> run.threads >> separator;
+    if (!std::getline(fields, bound, ',') || !std::getline(fields, engine, ',') || !std::getline(fields, search, ',') || !std::getline(fields, expansion, ',') 
+        || !std::getline(fields, branching, ','))
+    {
+        return false;
+    }
+    fields >> run.dominanceCacheMegabytes >> separator >> run.warmStart >> separator >> run.routeCost >> separator >> run.nodesExpanded >> separator >> run.nodesPerSecond >> separator
+        >> run.firstRouteMilliseconds >> separator >> run.bestRouteMilliseconds >> separator >> run.proofMilliseconds >> separator
+        >> run.peakQueueSize >> separator >> run.peakResidentKilobytes;
+    run.instanceType = type;
+    run.bound = bound;
+    run.engine = engine;
+    run.search = search;
+    run.expansion = expansion;
+    run.branching = branching;
+    return !fields.fail();
+}
+
+/*
+    Matches each run against the row with the same key in the baseline file and reports:
+        - a different route cost (the search is exact, so one of the two builds is wrong)
+        - a different number of nodes expanded, for single-threaded runs (the only ones where the count is deterministic)
+        - a proof time more than the tolerance above the baseline's, ignoring baseline runs shorter than SLOWDOWN_NOISE_FLOOR_MS
+    Returns false if a route cost differs or a run got slower, so the benchmark can gate a build; node count changes are only reported.
+*/
+bool compareWithBaseline(const std::vector<BenchmarkRun> &runs, const BenchmarkOptions &options)
+{
+    std::ifstream baselineFile(options.baselinePath.c_str());
+    if (!baselineFile)
+    {
+        std::cout << "Could not open baseline '" << options.baselinePath << "'." << std::endl;
+        return false;
+    }
+
+    std::map<std::string, BenchmarkRun> baseline;
+    std::string line;
+    while (std::getline(baselineFile, line))
+    {
+        BenchmarkRun run;
+        if (parseRun(line, run))
+        {
+            baseline[runKey(run)] = run;
+        }
+    }
+
+    int matched = 0;
+    int failures = 0;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        std::map<std::string, BenchmarkRun>::const_iterator found = baseline.find(runKey(runs[i]));
+        if (found == baseline.end())
+        {
+            continue;
+        }
+        const BenchmarkRun &before = found->second;
+        const BenchmarkRun &after = runs[i];
+        matched++;
+
+        if (before.routeCost != after.routeCost)
+        {
+            std::cout << "COST    " << runKey(after) << ": " << before.routeCost << " -> " << after.routeCost << std::endl;
+            failures++;
+        }
+        if (after.threads == 1 && before.nodesExpanded != after.nodesExpanded)
+        {
+            std::cout << "NODES   " << runKey(after) << ": " << before.nodesExpanded << " -> " << after.nodesExpanded << std::endl;
+        }
+        if (before.proofMilliseconds >= SLOWDOWN_NOISE_FLOOR_MS && after.proofMilliseconds > before.proofMilliseconds * (1.0 + options.tolerance))
+        {
+            std::cout << "SLOWER  " << runKey(after) << ": " << before.proofMilliseconds << " ms -> " << after.proofMilliseconds << " ms" << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << matched << " of " << runs.size() << " runs matched the baseline, " << failures << " regression(s)." << std::endl;
+    return failures == 0;
+}
+
+/*
+    With more than one branching strategy, prints the totals of each over the runs solved by branch-and-bound: nodes expanded and proof time,
+    and how the nodes compare with the first strategy given. Every strategy solves the same instances with the same threads, so the totals 
+    compare directly. readInBenchmarkOptions() runs such sessions on the branch-and-bound engine, so every run counts; should none have 
+    branched after all, nothing is printed.
+*/
+void printBranchingSummary(const std::vector<BenchmarkRun> &runs, const BenchmarkOptions &options)
+{
+    if (options.branchingStrategies.size() < 2)
+    {
+        return;
+    }
+
+    std::vector<long long> nodesExpanded(options.branchingStrategies.size(), 0);
+    std::vector<double> proofMilliseconds(options.branchingStrategies.size(), 0);
+    int branchAndBoundRuns = 0;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        if (runs[i].engine != "bnb")
+        {
+            continue;
+        }
+        int b = i % options.branchingStrategies.size(); // The strategies are the innermost loop of main()
+        nodesExpanded[b] += runs[i].nodesExpanded;
+        proofMilliseconds[b] += runs[i].proofMilliseconds;
+        branchAndBoundRuns += b == 0 ? 1 : 0;
+    }
+    if (branchAndBoundRuns == 0)
+    {
+        return;
+    }
+
+    std::cout << "Branching strategies over " << branchAndBoundRuns << " branch-and-bound run(s):" << std::endl;
+    for (size_t b = 0; b < options.branchingStrategies.size(); b++)
+    {
+        std::cout << "  " << std::left << std::setw(12) << BRANCHING_STRATEGY_NAMES[options.branchingStrategies[b]] << std::right << std::setw(14) 
+            << nodesExpanded[b] << " nodes" << std::setw(12) << std::fixed << std::setprecision(1) << proofMilliseconds[b] << " ms";
+        if (b > 0 && nodesExpanded[0] > 0)
+        {
+            std::cout << std::setw(9) << std::setprecision(2) << double(nodesExpanded[b]) / nodesExpanded[0] << "x the nodes of " 
+                << BRANCHING_STRATEGY_NAMES[options.branchingStrategies[0]];
+        }
+        std::cout << std::endl;
+    }
+}
@@ -1,70 +1,83 @@
-#include <iostream>
-#include <queue>
-#include <iomanip>
-#include <vector>
-#include <thread>
-#include <set>
+#include "TravelingSalesmanSolver.h"
 
-// A node encapsulates a "route" in expansion
-struct node{
-    std::vector<std::vector<int>> configurationMatrix; // 2D matrix containing included/excluded edges, and information (in the last 2 cells) to determine if further edges can be included/excluded
-    double lowerBound; // Smallest cost of all edges in the route; sums the cost of the current included edges with the least cost edges 
-    std::pair<int, int> constraint; // Indexes a cell (edge) that will be examined for possible inclusion/exclusion
-    bool include; // Set to true if the constraint cell can be included
-    bool exclude; // Set to true if the constraint cell can be excluded
-    std::vector<int> previouslyVisited; // Vector containing cities previously visited. Important for disallowing multiple cycles (TSP allows every city to only be visited once (except home city))
-};
+#include <fstream>
+#include <sstream>
+
+const char *const BATCH_COLUMNS = "index,instance,status,cities,engine,route_cost,lower_bound,nodes_expanded,solve_ms,route";
+const char *const USAGE = "Usage: TSP [--instance FILE | --simulation 5|6|7 | --batch FILE | --connect ADDRESS] [--threads N] [--bound simple|onetree]\n"
+    "           [--engine auto|bnb|dp|lk] [--restarts N] [--seed N] [--search bestfirst|dfs|hybrid] [--memory-budget MB]\n"
+    "           [--expansion edge|row] [--dominance-cache MB] [--branching rowmajor|constrained|penalty|strong] [--no-warm-start]\n"
+    "           [--log silent|summary|trace] [--log-file FILE] [--time-limit SECONDS] [--node-limit N] [--progress SECONDS]\n"
+    "           [--stats FILE] [--checkpoint FILE] [--checkpoint-interval SECONDS] [--resume FILE] [--listen ADDRESS] [--workers N]";
 
-int TOTAL = 0;
-enum City { A, B, C, D, E, F, G };
+/*
+    Work shared by the pool threads of a batch (see solveBatch()). Each thread takes the next unclaimed instance until none are left, so a 
+    thread that drew small instances simply solves more of them.
+*/
+struct BatchJob {
+    std::vector<std::string> instancePaths;
+    const ProgramVariables *options; // Solver options every instance is solved with
+    std::atomic<size_t> nextInstance;
+    std::atomic<int> failedInstances;
+    std::mutex outputMutex; // Keeps the result rows whole when several threads finish at once
+
+    BatchJob() : options(NULL), nextInstance(0), failedInstances(0) {}
+};
 
 int readInSimulationMode();
-node initializeConfigurationMatrix();
-void setAdjacencyMatrix();
-void nodeExpansionDispatcher(node root);
-bool updateNodeConstraint(node &node);
-void setNodeFlags(node &node);
-bool checkForCycles(node nodeX);
-void checkInclude(node poppedNode, int id);
-void checkExclude(node poppedNode, int id);
-void modifyMatrix(node &node, bool include);
-void calculateLowerBoundForNodeUpdated(node &node); 
-void pruneNodesUpdated();
-void print(node s);
-std::string cityToString(City city);
-void printBestRoute(node node);
+bool readInCommandLineOptions(int argc, char* argv[], ProgramVariables &programVariables);
+bool readBatchManifest(const std::string &path, std::vector<std::string> &instancePaths);
+bool solveBatch(const ProgramVariables &options);
+void batchWorker(BatchJob &job);
 
-// Compares the lower bounds of two nodes, returns true if p1.lB > p2.lB. Used as comparison function for priority queue.
-struct Comparator {
-    bool operator()(node const& p1, node const& p2)
-    {        
-        return p1.lowerBound > p2.lowerBound;
+// Driver method
+int main(int argc, char* argv[])
+{
+    TravelingSalesmanSolver solver;
+    ProgramVariables &programVariables = solver.programVariables;
+    if (!readInCommandLineOptions(argc, argv, programVariables))
+    {
+        std::cout << USAGE << std::endl;
+        return 1;
     }
-};
 
-struct ProgramVariables {
-    /*
-        Priority_Queue is a container adapter in the C++ standard library. The first parameter "node" specifies the type being stored.
-        The second parameter vector<node> specifies how to store that type, which in this case is a vector of nodes. The third parameter 
-        specifies the comparison function which determines how the nodes are stored. The comparator above is used as this function.
-    */
-    std::priority_queue<node, std::vector<node>, Comparator> unprocessedNodesQueue; // Contains all nodes that can still be expanded (not complete routes)
-    std::vector<std::vector<int> > adjacencyMatrix; // 2D matrix where each cell is the cost between cities. Ex: [a][b] = cost from a->b, b->a
-    node foundRoute; 
-    bool endProgram = false; 
-    int numberOfCitiesToVisit;
-};
+    if (!programVariables.batchPath.empty())
+    {
+        return solveBatch(programVariables) ? 0 : 1;
+    }
+    if (!programVariables.coordinatorAddress.empty())
+    {
+        return solver.solveAsWorker() ? 0 : 1; // The instance comes from the coordinator
+    }
 
-pthread_mutex_t printMutex = PTHREAD_MUTEX_INITIALIZER;
-ProgramVariables programVariables;
+    if (!programVariables.instancePath.empty())
+    {
+        if (!solver.loadInstanceFile(programVariables.instancePath))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        programVariables.numberOfCitiesToVisit = programVariables.simulationMode != 0 ? programVariables.simulationMode : readInSimulationMode(); 
+        if (programVariables.numberOfCitiesToVisit == 0)
+        {
+            return 1; // The input ended before a simulation was chosen
+        }
+        solver.setAdjacencyMatrix();
+    }
 
-// Driver method
-int main()
-{
-    programVariables.numberOfCitiesToVisit = readInSimulationMode(); 
-    node root = initializeConfigurationMatrix(); 
-    setAdjacencyMatrix();
-    nodeExpansionDispatcher(root); // Starts the multithreaded route discovery process
+    bool solved = programVariables.listenAddress.empty() ? solver.solveLoadedInstance() // Starts the multithreaded route discovery process
+        : solver.solveAsCoordinator();
+    if (!solved)
+    {
+        return 1;
+    }
+    solver.printSearchResults();
+    if (!programVariables.statisticsPath.empty() && !solver.writeStatisticsReport(programVariables.statisticsPath))
+    {
+        return 1;
+    }
     return 0;
    
 }
@@ -72,6 +85,7 @@ int main()
 /*
     This method will prompt the user to enter '5' for the 5-city simulation, '6' for the 6-city simulation, or '7' for the 7-city simulation.
     Invalid inputs (anything other than numerical '5', '6', or '7') will be rejected and prompt the user to enter a new choice.
+    Returns 0 if the input ends before a valid choice is made.
 */
 int readInSimulationMode()
 {
@@ -90,6 +104,11 @@ int readInSimulationMode()
         std::cout << "\t Choice: ";
         std::cin >> input;
 
+        if (std::cin.eof() && std::cin.fail()) // Nothing left to read, e.g. stdin is /dev/null
+        {
+            std::cout << std::endl << "No simulation was chosen." << std::endl;
+            return 0;
+        }
         if (std::cin.fail() || input > 7 || input < 5) // Cin.fail() is true when a non-integer input is entered, due to cin >> input (input is integer)
         { 
             std::cout << "Invalid input."  << std::endl << std::endl;
@@ -109,491 +128,469 @@ int readInSimulationMode()
 }
 
 /*
-    The configurationMatrix is a 2D matrix associated with each node. The size of the matrix depends on the numberOfCities that will be used in 
-    the simulation. For example, if the user chose the 5-city simulation, the 2D matrix will be of size [5][7]. The 5 x 5 part of the matrix contains 
-    either '0', '1', or '-1'. A cell will contain '1' if the edge has been included in the node's current route, and '-1' if the edge has been excluded 
-    (meaning that edge is not in the route). It was stated that the size of the 5-city 2D configurationMatrix for a node is [5][7], and this is because
-    two extra columns are needed to hold information to decipher whether an edge for that row can be included or excluded. The decision is made with the 
-    information in each of these last two columns.
-
-    The method below initializes the configurationMatrix for the root node. To continue with the 5-city example, this method will set the 5 x 5 cells to all '0s'. The last
-    column will be set to all '4s', and the 2nd to last column will again be set to all '0s'. More information can be found in the readME file.
-*/
-node initializeConfigurationMatrix()
-{
-    node root;
-    int numberOfColumns = programVariables.numberOfCitiesToVisit + 2; 
-    int numberOfRows = programVariables.numberOfCitiesToVisit;
-    int lastColumn = programVariables.numberOfCitiesToVisit + 1;
-    std::vector<std::vector<int> > configurationMatrix(programVariables.numberOfCitiesToVisit, std::vector<int>(numberOfColumns)); // Creates 2D vector of ints, with row size = # of cities, column size = (# cities + 2)
-
-    for(int row = 0; row < numberOfRows; row++)
-        {
-            for(int column = 0; column < numberOfColumns; column++)
-            {
-                if(column == lastColumn) // Exclude column 
-                {
-                    configurationMatrix[row][column] = (programVariables.numberOfCitiesToVisit - 1);
-                }
-                else // All other columns
-                {
-                    configurationMatrix[row][column] = 0;
-                }  
-            } 
-        }
-        
-        root.configurationMatrix = configurationMatrix;
-        root.constraint.first = 0;
-        root.constraint.second = 0;
-        root.lowerBound = 0;
-        
-        return root;
-        
-}
-
-/*
-    Depending on whether the user chose to run the 5-city, 6-city, or 7-city simulation, the adjacencyMatrix (a global 2D matrix containing costs to travel from city to city)
-    will be set. A cell in the adjacencyMatrix can be interpreted as such: [x][y] would correspond to the cost of traveling from city x to city y. The values 
-    for each of the simulations are trivial and randomly chosen. It's also important to note [x][x] is 0 for all cities, meaning the cost to travel from 
-    a city to itself is 0.
-*/
-void setAdjacencyMatrix()
-{
-    if(programVariables.numberOfCitiesToVisit == 5)
-    {
-        std::vector<std::vector<int> > fiveCitySimulation {
-        {0, 3, 4, 2, 7},    
-        {3, 0, 4, 6, 3},    
-        {4, 4, 0, 5, 8},    
-        {2, 6, 5, 0, 6},    
-        {7, 3, 8, 6, 0}     
-    };
-
-        programVariables.adjacencyMatrix = fiveCitySimulation;
-    }
-
-    else if(programVariables.numberOfCitiesToVisit == 6)
-    {
-        std::vector<std::vector<int> > sixCitySimulation {
-        {0, 2, 4, 1, 7, 2},   
-        {3, 0, 2, 7, 3, 4},   
-        {4, 9, 0, 7, 8, 2},   
-        {2, 9, 5, 0, 6, 6},   
-        {7, 9, 8, 7, 0, 2},   
-        {3, 9, 5, 7, 2, 0},           
-    };
-        programVariables.adjacencyMatrix = sixCitySimulation;
-    }
-    else
-    {
-        std::vector<std::vector<int> > sevenCitySimulation {
-        {0, 6, 8, 2, 6, 1, 9},   
-        {6, 0, 5, 4, 1, 9, 2},   
-        {8, 5, 0, 6, 1, 1, 8},   
-        {2, 4, 6, 0, 2, 9, 3},   
-        {6, 1, 1, 2, 0, 2, 9},   
-        {1, 9, 1, 9, 2, 0, 7},
-        {9, 2, 8, 3, 9, 7, 0}, 
-
-    };
-    programVariables.adjacencyMatrix = sevenCitySimulation;
-    }
-}
-
-/*
-    This dispatcher method contains the main program loop, which is carried out as follows: a node is first popped from the unprocssedNodesQueue, and 
-    is checked to see if it can be expanded further. If a node cannot be expanded, that node contains a route and  It will then be used to prune nodes 
-    from the unprocessedNodesQueue who contain higher lower bounds than it. 
-
-    If a route is not found, it is determined whether the node can include or exclude another edge in that row. For each of the conditions that evaluate
-    to true, a thread will be created and carry out the process of creating another node that contains that include/excluded edge. This(these) node(s) will then
-    be added back into the unprocessedNodesQueue for further expansion.
+    Reads the optional command line switches:
+        --threads N (or -t N)        number of worker threads; defaults to one per hardware core
+        --bound simple|onetree       lower bound given to each node; defaults to simple (two cheapest edges per city). onetree selects the
+                                     Held-Karp 1-tree bound, which costs more per node but prunes far more on larger instances
+        --engine auto|bnb|dp|lk      engine; auto (the default) uses the Held-Karp dynamic program (dp) up to AUTO_HELD_KARP_MAX_CITIES
+                                     cities, the branch-and-bound search (bnb) up to MAX_CITIES and the Lin-Kernighan heuristic (lk) above.
+                                     lk takes any number of cities but does not prove its route optimal (see linKernighanDispatcher())
+        --restarts N                 tours the lk engine builds and improves, spread over the threads; defaults to one per thread
+        --seed N                     random seed of the first lk restart; defaults to 1
+        --search bestfirst|dfs|hybrid order of the branch-and-bound search; bestfirst (the default) always expands the queued node with the
+                                     lowest bound. dfs and hybrid search the subtree of a popped node depth-first once the queues hold a few
+                                     nodes per worker (dfs) or reach the memory budget (hybrid), so memory stops growing
+        --memory-budget MB           size of the queues at which the hybrid search turns depth-first; defaults to 1024
+        --expansion edge|row         how the best-first search expands a popped node; edge (the default) branches on one edge, row on every
+                                     edge left in the row and queues the children together (row-major branching only, see expandRow())
+        --dominance-cache MB         drop nodes dominated by a cheaper node with the same fragments, remembered in a table of MB; 0 (the default) for none
+        --branching rowmajor|constrained|penalty|strong
+                                     how the edge each node branches on is picked; rowmajor (the default) walks the matrix row by row,
+                                     the others pick by cost or by effect on the bound (see chooseBranchingEdge())
+        --instance FILE              solve the instance in FILE (TSPLIB, or a plain cost matrix) instead of a built-in simulation
+        --simulation 5|6|7           run a built-in simulation without prompting for it
+        --no-warm-start              start the search without a heuristic route (see seedFoundRouteWithHeuristic())
+        --log silent|summary|trace   silent only prints the best route; summary (the default) adds load, starting route and search totals;
+                                     trace also records every node expansion in the trace file
+        --log-file FILE              trace file; defaults to tsp_trace.log
+        --time-limit SECONDS         stop the search after SECONDS (from the start of the solve) and print the best route found so far
+        --node-limit N               stop the search after N nodes have been expanded
+                                     Under a limit the best route and the proven lower bound are printed; auto picks branch-and-bound
+        --progress SECONDS           print a progress line (nodes, queue, pruning, best route, bound and gap) every SECONDS during the search
+        --stats FILE                 write the search statistics to FILE as JSON after the solve, including the time spent in the bound, 
+                                     the cycle check and the queues (which are only measured with this switch)
+        --checkpoint FILE            save the branch-and-bound search (queued nodes and best route) to FILE every checkpoint interval 
+                                     and when the search ends, so that it can be resumed; auto picks branch-and-bound
+        --checkpoint-interval SECONDS interval between two checkpoints; defaults to DEFAULT_CHECKPOINT_SECONDS
+        --resume FILE                continue the search saved in FILE instead of starting it over; the instance and the bound must be 
+                                     the ones it was taken with
+        --batch FILE                 solve every instance listed in FILE (see solveBatch()) instead of a single one; checkpoints do not
+                                     apply to a batch
+        --listen ADDRESS             solve the instance as the coordinator of a distributed search (see solveAsCoordinator()), with
+                                     worker processes connecting to ADDRESS: "unix:PATH", "HOST:PORT" or "PORT"
+        --workers N                  number of worker processes the coordinator waits for; defaults to 1
+        --connect ADDRESS            work for the coordinator at ADDRESS instead of solving an instance of this process's own
+    Invalid values are reported and fall back to the default. Returns false (after printing the reason) for an unknown switch or a switch 
+    without its value, so that a mistyped switch cannot silently turn a batch run into an interactive one.
 */
-void nodeExpansionDispatcher(node root) 
+bool readInCommandLineOptions(int argc, char* argv[], ProgramVariables &programVariables)
 {
-    programVariables.unprocessedNodesQueue.push(root);
+    int threads = std::thread::hardware_concurrency();
 
-    while (!programVariables.unprocessedNodesQueue.empty()) // Program loop starts
+    for (int i = 1; i < argc; i++)
     {
-        node poppedNode = programVariables.unprocessedNodesQueue.top(); 
-        programVariables.unprocessedNodesQueue.pop();
-        bool routeFound = updateNodeConstraint(poppedNode); // Initially the constraint for the root node is <0><0>; this updates it to <0><1>. For more details on how the update is carried out, check updateNodeConstraint()
-
-        if (routeFound) 
+        if (std::strcmp(argv[i], "--no-warm-start") == 0)
         {
-            programVariables.foundRoute = poppedNode;
-            pruneNodesUpdated();
+            programVariables.warmStart = false;
+            continue;
         }
-        
-        setNodeFlags(poppedNode); // Sets each of poppedNode.include and poppedNode.exclude depending on whether or not inclusion/exclusion is possible
-       
-        if (!programVariables.endProgram) 
+        if (i + 1 == argc) // Every other switch takes a value
         {
-            std::thread includeThread(checkInclude, poppedNode, 1); // Thread created to check if edge can be included
-            std::thread excludeThread(checkExclude, poppedNode, 2); // Thread created to check if edge can be excluded
-            includeThread.join();
-            excludeThread.join();  
+            std::cout << "Switch '" << argv[i] << "' is unknown or missing its value." << std::endl;
+            return false;
         }
-       
-    }
-
-        std::cout << "Best route obtained: " << programVariables.foundRoute.lowerBound << std::endl << std::endl;
-        print(programVariables.foundRoute); 
-        printBestRoute(programVariables.foundRoute);
-
-}
-
-/*
-    The constraint for a node is updated column by column until the end of the row is reached. Upon reaching the end of a row, the row is incremented and the column is 
-    set to the row + 1. Using the 5-city simulation as an example, the constraint would start at <0><0> and would be incremented column by column until it reached <0><4>. 
-    The next update would set the constraint to <1><2>, and consecutive updates would go back to column by column until the end of the row was reached again. 
-
-    This method is also important in that it returns true if a route is found. A route is found when the constraint can no longer be updated. In the 5-city simulation,
-    this would be at <3><4>, for if we tried to update the constraint, we would have <4><5> and fall off the matrix. 
-*/
-bool updateNodeConstraint(node &nodeX)
-{
-    bool foundRoute = false;
-    int currentRow = nodeX.constraint.first;
-    int currentColumn = nodeX.constraint.second;
-    int lastCityIndex = programVariables.numberOfCitiesToVisit - 1; 
-    int secondToLastRow = programVariables.numberOfCitiesToVisit - 2;
 
-    if((currentRow == secondToLastRow) && (currentColumn == lastCityIndex)) // Constraint cannot be updated further; a route has been found
-    {
-        std::cout << "Route found. " << std::endl;
-        foundRoute = true; 
-    }
-    else
-    {
-        if (currentColumn == lastCityIndex) // If the last index is reached, increment the row and set the column to the row + 1
+        if (std::strcmp(argv[i], "--threads") == 0 || std::strcmp(argv[i], "-t") == 0)
+        {
+            int requested = std::atoi(argv[i + 1]);
+            if (requested > 0)
+            {
+                threads = requested;
+            }
+            else
+            {
+                std::cout << "Invalid thread count '" << argv[i + 1] << "', using the default." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--bound") == 0)
         {
-            ++currentRow;
-            currentColumn = currentRow + 1;
+            if (std::strcmp(argv[i + 1], "onetree") == 0)
+            {
+                programVariables.boundType = ONE_TREE_BOUND;
+            }
+            else if (std::strcmp(argv[i + 1], "simple") == 0)
+            {
+                programVariables.boundType = SIMPLE_BOUND;
+            }
+            else
+            {
+                std::cout << "Invalid bound '" << argv[i + 1] << "', using the simple bound." << std::endl;
+            }
         }
-        else // Most common, simply increment the column
+        else if (std::strcmp(argv[i], "--engine") == 0)
         {
-            ++currentColumn;
+            if (std::strcmp(argv[i + 1], "auto") == 0)
+            {
+                programVariables.engine = AUTO_ENGINE;
+            }
+            else if (std::strcmp(argv[i + 1], "bnb") == 0)
+            {
+                programVariables.engine = BRANCH_AND_BOUND_ENGINE;
+            }
+            else if (std::strcmp(argv[i + 1], "dp") == 0)
+            {
+                programVariables.engine = HELD_KARP_ENGINE;
+            }
+            else if (std::strcmp(argv[i + 1], "lk") == 0)
+            {
+                programVariables.engine = LIN_KERNIGHAN_ENGINE;
+            }
+            else
+            {
+                std::cout << "Invalid engine '" << argv[i + 1] << "', choosing the engine automatically." << std::endl;
+            }
         }
-        
-    }
-
-    // Set constraint for node to updated values
-    nodeX.constraint.first = currentRow; 
-    nodeX.constraint.second = currentColumn;
-    
-    return foundRoute;
-}
-
-/*
-    Each node contains boolean variables to indicate whether the current edge given by the constraint can be included or excluded. This method will 
-    set those boolean variables by examining the last two columns of the configurationMatrix. The second to last column will give the number of edges
-    that have been included for each row, and last column will give the total number of edges that can still be included or excluded. When the configurationMatrix
-    for the root node is first initialized, the last column is set to numberOfCitiesToVisit - 1. To use the 5-city simulation as an example, the last column
-    will be initialized to 4, meaning 4 edges in each row can be included or excluded. 
-
-    When an edge is included, the include column is incremented, and the exclude column is decremented. When an edge is excluded, only the exclude column is decremented.
-*/
-void setNodeFlags(node &nodeX)
-{
-    nodeX.include = false;;
-    nodeX.exclude = true;;
-    int currentRow = nodeX.constraint.first;
-    int includeColumn = programVariables.numberOfCitiesToVisit; // # of edges included in a row
-    int excludeColumn = programVariables.numberOfCitiesToVisit + 1; // # of edges that can be included/excluded in a row
-
-    if(nodeX.configurationMatrix[currentRow][includeColumn] < 2) // For an edge to be included, it cannot have 2 edges already included in that row
-    {
-        if(nodeX.configurationMatrix[currentRow][includeColumn] == 0 && nodeX.configurationMatrix[currentRow][excludeColumn] >= 2) // If no edges have been included, and there is still 2 available edges to include/exclude (given by the exclude column), the edge is safe to include
+        else if (std::strcmp(argv[i], "--search") == 0)
+        {
+            if (std::strcmp(argv[i + 1], "bestfirst") == 0)
+            {
+                programVariables.searchMode = BEST_FIRST_SEARCH;
+            }
+            else if (std::strcmp(argv[i + 1], "dfs") == 0)
+            {
+                programVariables.searchMode = DEPTH_FIRST_SEARCH;
+            }
+            else if (std::strcmp(argv[i + 1], "hybrid") == 0)
+            {
+                programVariables.searchMode = HYBRID_SEARCH;
+            }
+            else
+            {
+                std::cout << "Invalid search '" << argv[i + 1] << "', using best-first." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--branching") == 0)
         {
-            nodeX.include = true;
+            const char *const *found = std::find_if(BRANCHING_STRATEGY_NAMES, BRANCHING_STRATEGY_NAMES + NUMBER_OF_BRANCHING_STRATEGIES, 
+                [&argv, i](const char *name) { return std::strcmp(argv[i + 1], name) == 0; });
+            if (found != BRANCHING_STRATEGY_NAMES + NUMBER_OF_BRANCHING_STRATEGIES)
+            {
+                programVariables.branchingStrategy = BranchingStrategy(found - BRANCHING_STRATEGY_NAMES);
+            }
+            else
+            {
+                std::cout << "Invalid branching '" << argv[i + 1] << "', using row-major." << std::endl;
+            }
         }
-        else if(nodeX.configurationMatrix[currentRow][includeColumn] == 1 && nodeX.configurationMatrix[currentRow][excludeColumn] >= 1) // If 1 edge has been included, and there is at least 1 available edge to include/exclude (given by the exclude column), the edge is safe to include
+        else if (std::strcmp(argv[i], "--restarts") == 0)
         {
-            nodeX.include = true;
+            int restarts = std::atoi(argv[i + 1]);
+            if (restarts > 0)
+            {
+                programVariables.restarts = restarts;
+            }
+            else
+            {
+                std::cout << "Invalid restart count '" << argv[i + 1] << "', using one per thread." << std::endl;
+            }
         }
-    }
-
-
-    bool canInclude = checkForCycles(nodeX);
-    nodeX.include = canInclude;
-    // Check if the city (constraint.first) has been included previously. If this is the case, we need to make sure we are not visiting a city that we have also been to (would create a cycle)
-    
-
-    // These selection statements determine whether an edge can be excluded. There are two cases where we cannot exclude:
-    if(nodeX.configurationMatrix[currentRow][excludeColumn] == 2 && nodeX.configurationMatrix[currentRow][includeColumn] == 0) // If the exclude column has 2 edges that can be included/excluded AND we have currently 0 included edges
-    {
-        nodeX.exclude = false; 
-    }
-
-    // If 1 edge can be included/excluded AND we either have 1 edge left to include, or 0 edges left to include, we CANNOT exclude
-    if(nodeX.configurationMatrix[currentRow][excludeColumn] == 1 && (nodeX.configurationMatrix[currentRow][includeColumn] == 1 || nodeX.configurationMatrix[currentRow][includeColumn] == 0 )) 
-    {
-        nodeX.exclude = false;
-    }
-}
-
-
-bool checkForCycles(node nodeX)
-{
-    bool previouslyIncluded = false;
-
-    for(int i = 0; i < nodeX.previouslyVisited.size(); i++)
-    {
-        if(nodeX.constraint.first == nodeX.previouslyVisited[i])
+        else if (std::strcmp(argv[i], "--seed") == 0)
         {
-            previouslyIncluded = true;
+            programVariables.seed = unsigned(std::strtoul(argv[i + 1], NULL, 10));
         }
-    }
-
-    
-    if(previouslyIncluded)
-    {
-        // Check that we are not including a city we have already visited 
-        for(int j = 0; j < nodeX.previouslyVisited.size(); j++)
+        else if (std::strcmp(argv[i], "--expansion") == 0)
         {
-            if(nodeX.constraint.second == nodeX.previouslyVisited[j] && nodeX.constraint.first != programVariables.numberOfCitiesToVisit - 2)
+            if (std::strcmp(argv[i + 1], "edge") == 0)
+            {
+                programVariables.expansionMode = EDGE_EXPANSION;
+            }
+            else if (std::strcmp(argv[i + 1], "row") == 0)
+            {
+                programVariables.expansionMode = ROW_EXPANSION;
+            }
+            else
             {
-                return false;
+                std::cout << "Invalid expansion '" << argv[i + 1] << "', using edge." << std::endl;
             }
         }
+        else if (std::strcmp(argv[i], "--dominance-cache") == 0)
+        {
+            long long megabytes = std::atoll(argv[i + 1]);
+            if (megabytes > 0 || std::strcmp(argv[i + 1], "0") == 0)
+            {
+                programVariables.dominanceCacheBytes = megabytes << 20;
+            }
+            else
+            {
+                std::cout << "Invalid dominance cache size '" << argv[i + 1] << "', using none." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--memory-budget") == 0)
+        {
+            long long megabytes = std::atoll(argv[i + 1]);
+            if (megabytes > 0)
+            {
+                programVariables.memoryBudget = megabytes << 20;
+            }
+            else
+            {
+                std::cout << "Invalid memory budget '" << argv[i + 1] << "', using " << DEFAULT_MEMORY_BUDGET_MB << " MB." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--log") == 0)
+        {
+            if (std::strcmp(argv[i + 1], "silent") == 0)
+            {
+                programVariables.logLevel = LOG_SILENT;
+            }
+            else if (std::strcmp(argv[i + 1], "summary") == 0)
+            {
+                programVariables.logLevel = LOG_SUMMARY;
+            }
+            else if (std::strcmp(argv[i + 1], "trace") == 0)
+            {
+                programVariables.logLevel = LOG_TRACE;
+            }
+            else
+            {
+                std::cout << "Invalid log level '" << argv[i + 1] << "', using summary." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--log-file") == 0)
+        {
+            programVariables.traceLogPath = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--time-limit") == 0)
+        {
+            double seconds = std::atof(argv[i + 1]);
+            if (seconds > 0)
+            {
+                programVariables.timeLimitSeconds = seconds;
+            }
+            else
+            {
+                std::cout << "Invalid time limit '" << argv[i + 1] << "', the search will not be limited in time." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--node-limit") == 0)
+        {
+            long long nodes = std::atoll(argv[i + 1]);
+            if (nodes > 0)
+            {
+                programVariables.nodeLimit = nodes;
+            }
+            else
+            {
+                std::cout << "Invalid node limit '" << argv[i + 1] << "', the search will not be limited in nodes." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--progress") == 0)
+        {
+            double seconds = std::atof(argv[i + 1]);
+            if (seconds > 0)
+            {
+                programVariables.progressSeconds = seconds;
+            }
+            else
+            {
+                std::cout << "Invalid progress interval '" << argv[i + 1] << "', no progress will be printed." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0)
+        {
+            programVariables.statisticsPath = argv[i + 1];
+            programVariables.timeSearchPhases = true;
+        }
+        else if (std::strcmp(argv[i], "--checkpoint") == 0)
+        {
+            programVariables.checkpointPath = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--checkpoint-interval") == 0)
+        {
+            double seconds = std::atof(argv[i + 1]);
+            if (seconds > 0)
+            {
+                programVariables.checkpointSeconds = seconds;
+            }
+            else
+            {
+                std::cout << "Invalid checkpoint interval '" << argv[i + 1] << "', using " << DEFAULT_CHECKPOINT_SECONDS << " seconds." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--resume") == 0)
+        {
+            programVariables.resumePath = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--listen") == 0)
+        {
+            programVariables.listenAddress = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0)
+        {
+            int requested = std::atoi(argv[i + 1]);
+            if (requested > 0)
+            {
+                programVariables.workerProcesses = requested;
+            }
+            else
+            {
+                std::cout << "Invalid worker process count '" << argv[i + 1] << "', waiting for one worker." << std::endl;
+            }
+        }
+        else if (std::strcmp(argv[i], "--connect") == 0)
+        {
+            programVariables.coordinatorAddress = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--batch") == 0)
+        {
+            programVariables.batchPath = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--instance") == 0)
+        {
+            programVariables.instancePath = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--simulation") == 0)
+        {
+            int requested = std::atoi(argv[i + 1]);
+            if (requested >= 5 && requested <= 7)
+            {
+                programVariables.simulationMode = requested;
+            }
+            else
+            {
+                std::cout << "Invalid simulation '" << argv[i + 1] << "', the simulation will be chosen interactively." << std::endl;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown switch '" << argv[i] << "'." << std::endl;
+            return false;
+        }
+        i++; // The value was used above
     }
-    return true;    
-
-}
 
-
-/*
-    This method is called after it is determined that the current cell edge (given by the constraint) can be included. In order
-    to ensure no race conditions when printing to console, a mutex is used around the cout stream.
-*/
-void checkInclude(node nodeX, int id)
-{
-    
-    if (nodeX.include)
+    programVariables.numberOfThreads = threads > 0 ? threads : 1; // hardware_concurrency() may return 0 if the core count is unknown
+    if (programVariables.expansionMode == ROW_EXPANSION && programVariables.branchingStrategy != ROW_MAJOR_BRANCHING)
     {
-        modifyMatrix(nodeX, true); // Adds the edge that will be included to the appropriate configurationMatrix cell
-        nodeX.lowerBound += programVariables.adjacencyMatrix[nodeX.constraint.first][nodeX.constraint.second]; // update lowerbound
-        TOTAL++;
-        std::cout << "Total: " << TOTAL << std::endl << std::endl;
-        //calculateLowerBoundForNodeUpdated(nodeX); // Calculates new lower bound with consideration for included edge
-
-        pthread_mutex_lock(&printMutex);
-        std::cout << "* * * * * * * * * * * * * * *" << std::endl << std::endl;
-        std::cout << "Thread " << id << " executing..." << std::endl;
-        std::cout << "Including edges at " << "[" << nodeX.constraint.first << "][" << nodeX.constraint.second << "]"<< " & ["<< nodeX.constraint.second << "][" << nodeX.constraint.first << "]"<<  std::endl;
-        print(nodeX);
-        pthread_mutex_unlock(&printMutex);
-
-        nodeX.previouslyVisited.push_back(nodeX.constraint.first);
-        nodeX.previouslyVisited.push_back(nodeX.constraint.second); // A node carries along a vector of cities that have been visited. This is important for disallowing cycles, and is checked in checkConstraint()
-        programVariables.unprocessedNodesQueue.push(nodeX); // The node, now having an updated lowerbound and constraint, is pushed back into the unprocessedNodesQueue            
+        std::cout << "--expansion row only applies to rowmajor branching; expanding one edge per node." << std::endl;
     }
-    else
-    {   
-        pthread_mutex_lock(&printMutex);
-        std::cout << "* * * * * * * * * * * * * * *" << std::endl << std::endl;
-        std::cout << "Thread " << id << " executing..." << std::endl;
-        std::cout << "Cannot further include. Terminating node. " << std::endl << std::endl;
-        pthread_mutex_unlock(&printMutex);
-    }
-
+    return true;
 }
 
 /*
-    This method is called after it is determined that the current cell edge (given by the constraint) can be included. 
+    Reads a batch manifest: one instance file per line (TSPLIB or a plain cost matrix, as with --instance). Blank lines and lines starting 
+    with '#' are skipped, and relative paths are taken relative to the manifest's directory. Returns false (after printing the reason) if 
+    the manifest cannot be read or lists no instance.
 */
-void checkExclude(node nodeX, int id)
+bool readBatchManifest(const std::string &path, std::vector<std::string> &instancePaths)
 {
-    
-    if (nodeX.exclude)
+    std::ifstream manifest(path.c_str());
+    if (!manifest)
     {
-        modifyMatrix(nodeX, false); // Adds the edge that will be excluded to the appropriate configurationMatrix cell
-        //calculateLowerBoundForNode(nodeX); // Calculates new lower bound with consideration for excluded edge
+        std::cout << "Could not open batch manifest '" << path << "'." << std::endl;
+        return false;
+    }
 
-        pthread_mutex_lock(&printMutex);
-        std::cout << "* * * * * * * * * * * * * * *" << std::endl << std::endl;
-        std::cout << "Thread " << id << " executing..." << std::endl;
-        std::cout << "Excluding edges at " << "[" << nodeX.constraint.first << "][" << nodeX.constraint.second << "]"<< " & ["<< nodeX.constraint.second << "][" << nodeX.constraint.first << "]"<<  std::endl;
-        print(nodeX);
-        pthread_mutex_unlock(&printMutex);  
-        
-        programVariables.unprocessedNodesQueue.push(nodeX);        
+    size_t lastSeparator = path.find_last_of("/\\");
+    std::string directory = lastSeparator == std::string::npos ? "" : path.substr(0, lastSeparator + 1);
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        std::string instancePath = line.substr(first, line.find_last_not_of(" \t\r") + 1 - first);
+        bool absolute = instancePath[0] == '/' || instancePath[0] == '\\' || (instancePath.size() > 1 && instancePath[1] == ':');
+        instancePaths.push_back(absolute ? instancePath : directory + instancePath);
     }
-    else
+
+    if (instancePaths.empty())
     {
-        pthread_mutex_lock(&printMutex);
-        std::cout << "* * * * * * * * * * * * * * *" << std::endl << std::endl;
-        std::cout << "Thread " << id << " executing" << std::endl;
-        std::cout << "Cannot further exclude. Terminating node. " << std::endl << std::endl;
-        pthread_mutex_unlock(&printMutex);
+        std::cout << "Batch manifest '" << path << "' lists no instances." << std::endl;
+        return false;
     }
+    return true;
 }
 
 /*
-    Each time an edge is included or excluded, this method is called to update the configurationMatrix for that node. 
-    If an edge is included, two cells are modified with '1s' (X -> Y and Y -> X, given by the constraint). The same is true
-    for excluded edges, except two cells are modified with '-1s'. 
+    Solves every instance of the batch manifest with the given options. The instances are independent, so rather than giving each one all 
+    the threads, a pool of numberOfThreads threads (one per hardware core by default) solves them concurrently, each instance on a single 
+    thread with a solver of its own. This keeps every core busy on batches of many small instances, where a single search spends much of 
+    its time on thread start-up and work stealing.
 
-    In addition, each modification to the matrix must updated the last two columns (include and exclude columns). If an edge
-    is added, the include column is incremented, and the exclude column decremented. Again, since we are modifying two cells in two
-    different rows, these columns must be updated for each row. If an edge is excluded, the exclude column only need to be decremented
-    in each of the rows.
+    A CSV row (BATCH_COLUMNS) is written as soon as an instance is solved, so rows come out in order of completion; index is the instance's
+    position in the manifest. Returns false if the manifest could not be read or any instance failed to load or solve.
 */
-void modifyMatrix(node &nodeX, bool include)
+bool solveBatch(const ProgramVariables &options)
 {
-    int currentRow = nodeX.constraint.first;
-    int currentColumn = nodeX.constraint.second;
-    int excludeColumn = programVariables.numberOfCitiesToVisit + 1;
-    int includeColumn = programVariables.numberOfCitiesToVisit;
-
-    if(include)
+    BatchJob job;
+    job.options = &options;
+    if (!readBatchManifest(options.batchPath, job.instancePaths))
     {
-        nodeX.configurationMatrix[currentRow][currentColumn] = 1; // Sets current cell to 1
-        nodeX.configurationMatrix[currentColumn][currentRow] = 1; // Sets the symmetrical cell to 1
-
-        nodeX.configurationMatrix[currentRow][includeColumn] += 1; // Increments includeColumn
-        nodeX.configurationMatrix[currentRow][excludeColumn] -= 1; // Decrements excludeColumn 
-        nodeX.configurationMatrix[currentColumn][includeColumn] += 1; // Same for symmetrical cell
-        nodeX.configurationMatrix[currentColumn][excludeColumn] -= 1; // Same for symmetrical cell
-        
+        return false;
     }
-    else
-    {
-        nodeX.configurationMatrix[currentRow][currentColumn] = -1; // Set current cell to -1
-        nodeX.configurationMatrix[currentColumn][currentRow] = -1; // Set symmetrical cell to -1
-
-        nodeX.configurationMatrix[currentRow][excludeColumn] -= 1; // Decrement excludeColumn
-        nodeX.configurationMatrix[currentColumn][excludeColumn] -= 1; // Same for symmetrical cell
-
-    }
-
-}
 
-/*
-    After a route is found, this method terminates all other nodes from the queue that have a higher lowerbound
-*/
-void pruneNodesUpdated()
-{
-   
-    while ((!programVariables.unprocessedNodesQueue.empty()))
+    std::cout << BATCH_COLUMNS << std::endl;
+    int poolSize = std::min<int>(options.numberOfThreads, job.instancePaths.size());
+    std::vector<std::thread> pool;
+    for (int i = 1; i < poolSize; i++)
     {
-        node unprocessedNode = programVariables.unprocessedNodesQueue.top(); // Each call to unprocessedNodesQueue.top will be the node with the lowest lowerBound
-
-        if (unprocessedNode.lowerBound >= programVariables.foundRoute.lowerBound)
-        {
-            std::cout << "Node terminated. Lowerbound: " << unprocessedNode.lowerBound << " > calculated Route " << std::endl << std::endl;
-            programVariables.unprocessedNodesQueue.pop();
-        }
-        else
-        {
-            break;
-        }
-       
+        pool.push_back(std::thread(batchWorker, std::ref(job)));
     }
-  
-    if (programVariables.unprocessedNodesQueue.empty())
+    batchWorker(job);
+    for (size_t i = 0; i < pool.size(); i++)
     {
-        std::cout << "The unprocessed nodes queue is empty, printing best route and ending program..." << std::endl << std::endl;
-        programVariables.endProgram = true;
+        pool[i].join();
     }
-  
 
+    return job.failedInstances.load() == 0;
 }
 
 /*
-    Prints the configurationMatrix for a node to the console.
+    One thread of the batch pool. The thread keeps one solver for all the instances it takes, resetting it in between, and writes each
+    instance's row as soon as it is done.
 */
-void print(node nodeX)
+void batchWorker(BatchJob &job)
 {
-    int character = 0;
-    char ch = 'A';
-    std::cout << "Lowerbound : " << nodeX.lowerBound << std::endl;
-    std::cout << "Configuration Matrix: " << std::endl << std::endl;
-    std::cout << std::setw(2);
-
-
-    // For each column, the alphabetical character that represents the city is printed
-    for(int i = 0; i < programVariables.numberOfCitiesToVisit; i++)
+    TravelingSalesmanSolver solver;
+    ProgramVariables &programVariables = solver.programVariables;
+    programVariables.numberOfThreads = 1;
+    programVariables.logLevel = LOG_SILENT; // The rows below are the only output on stdout; a trace would have every solver writing the same file
+    programVariables.boundType = job.options->boundType;
+    programVariables.engine = job.options->engine;
+    programVariables.restarts = job.options->restarts;
+    programVariables.seed = job.options->seed;
+    programVariables.searchMode = job.options->searchMode;
+    programVariables.branchingStrategy = job.options->branchingStrategy;
+    programVariables.memoryBudget = job.options->memoryBudget;
+    programVariables.expansionMode = job.options->expansionMode;
+    programVariables.dominanceCacheBytes = job.options->dominanceCacheBytes;
+    programVariables.warmStart = job.options->warmStart;
+    programVariables.timeLimitSeconds = job.options->timeLimitSeconds; // Per instance
+    programVariables.nodeLimit = job.options->nodeLimit;
+
+    for (size_t index = job.nextInstance++; index < job.instancePaths.size(); index = job.nextInstance++)
     {
-        character = int(ch);
-        std::cout << ch << "  ";
-        character++;
-        ch = char(character);
-    }
-
-    std::cout << "#1" << " " << "~#1" << std::endl; 
-    
-    
-    // Prints the values for each cell in the configurationMatrix
-    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
-    {
-        for (int column = 0; column < (programVariables.numberOfCitiesToVisit + 2); column++)
+        solver.resetProgramVariables();
+        bool solved = solver.loadInstanceFile(job.instancePaths[index]) && solver.solveLoadedInstance() 
+            && programVariables.bestRouteCost.load() != std::numeric_limits<double>::infinity();
+
+        std::ostringstream row;
+        const char *status = !solved ? "failed" : programVariables.stoppedByLimit ? "stopped" : programVariables.engineUsed == LIN_KERNIGHAN_ENGINE ? "heuristic" : "solved";
+        row << index << "," << job.instancePaths[index] << "," << status << "," << programVariables.numberOfCitiesToVisit << ",";
+        if (solved)
         {
-            std::cout << std::setw(2) << nodeX.configurationMatrix[row][column] << " ";
-        }
-        std::cout << std::endl;
-    }
-    
-    std::cout << std::endl;
-    std::cout << "Constraint: " << "<" << nodeX.constraint.first << "><" << nodeX.constraint.second << ">" << std::endl << std::endl;
-    
-}
-
-/*
-    City is an enumeration; this method sets City to a string
-*/
-std::string cityToString(City city) {
-    switch (city) {
-        case A: return "A";
-        case B: return "B";
-        case C: return "C";
-        case D: return "D";
-        case E: return "E";
-        case F: return "F";
-        case G: return "G";
-        default: return "";
-    }
-}
-
-/*
-    This method will begin at the starting city A, and print the lowest cost route city by city
-*/
-void printBestRoute(node nodeX)
-{
-    int numberOfCities = programVariables.numberOfCitiesToVisit;
-
-    std::vector<City> route;
-    std::set<City> visited;
-    City currentCity = A; // Start from city A
-
-    // While loop makes sure each city is only visited once
-    while (visited.size() < numberOfCities) {
-        route.push_back(currentCity);
-        visited.insert(currentCity);
-
-        for (int j = 0; j < numberOfCities; ++j) {
-            // If the edge has been include in the current column, and we have yet to visit the city
-            if (nodeX.configurationMatrix[currentCity][j] == 1 && visited.find(static_cast<City>(j)) == visited.end()) // visited.find returns visited.end() if not found (meaning city hasnt been visited)
+            std::vector<int> route = solver.bestRoute();
+            row << ENGINE_NAMES[programVariables.engineUsed] << "," << (long long)programVariables.bestRouteCost.load() << ",";
+            if (programVariables.provenLowerBound != std::numeric_limits<double>::infinity()) // Left empty for a heuristic route
             {
-                currentCity = static_cast<City>(j); // Cast j back to city
-                break;
+                row << programVariables.provenLowerBound;
+            }
+            row << "," << programVariables.nodesExpanded.load() << "," << programVariables.solveMilliseconds << ",";
+            for (size_t i = 0; i < route.size(); i++)
+            {
+                row << (i == 0 ? "" : " ") << route[i];
             }
         }
-    }
-
-    // Return to the starting city
-    route.push_back(A);
+        else
+        {
+            job.failedInstances++;
+            row << ",,,,,";
+        }
 
-    // Print the route
-    for (int i = 0; i < route.size() - 1; i++) {
-        std::cout << cityToString(route[i]) << " -> ";
+        std::lock_guard<std::mutex> lock(job.outputMutex);
+        std::cout << row.str() << std::endl;
     }
-    std::cout << cityToString(route.back()) << std::endl;
 }
-
-
-
-
-
-
@@ -0,0 +1,5607 @@
+#include "TravelingSalesmanSolver.h"
+
+#include <fstream>
+#include <sstream>
+#include <random>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h> // Before windows.h, which would otherwise pull in the older winsock.h
+#include <ws2tcpip.h>
+#include <windows.h>
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+inline int closeSocket(SocketHandle handle) { return closesocket(handle); }
+inline int pollSockets(pollfd *descriptors, size_t count, int milliseconds) { return WSAPoll(descriptors, ULONG(count), milliseconds); }
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+inline int closeSocket(SocketHandle handle) { return close(handle); }
+inline int pollSockets(pollfd *descriptors, size_t count, int milliseconds) { return poll(descriptors, count, milliseconds); }
+#endif
+
+/*
+    Solves the instance held in programVariables: the adjacencyMatrix is filled from the city coordinates (if the instance has any) and symmetrized,
+    and an engine is chosen. Instances of more than MAX_CITIES cities go to the Lin-Kernighan engine, which computes the costs of a coordinate 
+    instance from the coordinates instead of building the matrix. The Held-Karp engine solves instances of up to AUTO_HELD_KARP_MAX_CITIES cities unless another engine is 
+    requested; the branch-and-bound engine sets up the root node, builds the starting route (unless warmStart is off) and runs the search. 
+    When resuming, the queues and the best route are loaded from the checkpoint instead of starting from the root. The results are left in 
+    programVariables for printSearchResults() or the benchmark. Returns false (after printing the reason) if the instance is too small or 
+    too large to solve, or the checkpoint cannot be resumed.
+*/
+bool TravelingSalesmanSolver::solveLoadedInstance()
+{
+    bool heuristic = programVariables.engine == LIN_KERNIGHAN_ENGINE 
+        || (programVariables.engine == AUTO_ENGINE && programVariables.numberOfCitiesToVisit > MAX_CITIES);
+    if (programVariables.numberOfCitiesToVisit < 3 || (programVariables.numberOfCitiesToVisit > MAX_CITIES && !heuristic))
+    {
+        // Named after the engine asked for; auto takes the exact engines' range here, since it only turns heuristic above it
+        const char *engineName = heuristic ? "Lin-Kernighan engine" : programVariables.engine == HELD_KARP_ENGINE ? "Held-Karp engine" 
+            : programVariables.engine == BRANCH_AND_BOUND_ENGINE ? "branch-and-bound engine" : "solver";
+        std::cerr << "The " << engineName << " handles instances of 3 to " << (heuristic ? MAX_INSTANCE_CITIES : MAX_CITIES) << " cities; this one has " 
+            << programVariables.numberOfCitiesToVisit << "." << std::endl;
+        return false;
+    }
+
+    programVariables.solveStartTime = std::chrono::steady_clock::now();
+    programVariables.searchCounters.clear();
+    for (int i = 0; i < programVariables.numberOfThreads; i++)
+    {
+        programVariables.searchCounters.push_back(std::unique_ptr<SearchCounters>(new SearchCounters()));
+    }
+    if (heuristic)
+    {
+        if ((programVariables.nodeLimit > 0 || !programVariables.checkpointPath.empty() || !programVariables.resumePath.empty()) 
+            && programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "The Lin-Kernighan engine only takes the time limit; the node limit and checkpoints apply to branch-and-bound." << std::endl;
+        }
+        if (programVariables.cityCoordinates.empty())
+        {
+            symmetrizeAdjacencyMatrix();
+        }
+        else
+        {
+            programVariables.adjacencyMatrix.useCoordinates(&programVariables.cityCoordinates, programVariables.edgeWeightType);
+        }
+        programVariables.engineUsed = LIN_KERNIGHAN_ENGINE;
+        linKernighanDispatcher();
+        return true;
+    }
+    if (!programVariables.cityCoordinates.empty())
+    {
+        buildAdjacencyMatrixFromCoordinates();
+    }
+    symmetrizeAdjacencyMatrix();
+
+    SolverEngine engine = programVariables.engine;
+    bool limited = programVariables.timeLimitSeconds > 0 || programVariables.nodeLimit > 0;
+    bool checkpointed = !programVariables.checkpointPath.empty() || !programVariables.resumePath.empty();
+    if (engine == AUTO_ENGINE)
+    {
+        // The Held-Karp engine has no route until its last layer, so under a limit the branch-and-bound search (which always has one) is used.
+        // Only the branch-and-bound search can be checkpointed.
+        engine = programVariables.numberOfCitiesToVisit <= AUTO_HELD_KARP_MAX_CITIES && !limited && !checkpointed ? HELD_KARP_ENGINE : BRANCH_AND_BOUND_ENGINE;
+    }
+    else if (engine == HELD_KARP_ENGINE && programVariables.numberOfCitiesToVisit > HELD_KARP_MAX_CITIES)
+    {
+        if (programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "The Held-Karp engine handles up to " << HELD_KARP_MAX_CITIES << " cities; using branch-and-bound instead." << std::endl;
+        }
+        engine = BRANCH_AND_BOUND_ENGINE;
+    }
+    else if (engine == HELD_KARP_ENGINE && !programVariables.resumePath.empty())
+    {
+        if (programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "Checkpoints hold a branch-and-bound search; using branch-and-bound to resume." << std::endl;
+        }
+        engine = BRANCH_AND_BOUND_ENGINE;
+    }
+    programVariables.engineUsed = engine;
+    if (engine == HELD_KARP_ENGINE)
+    {
+        if ((limited || checkpointed) && programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "The Held-Karp engine runs to completion; the limits and checkpoints only apply to branch-and-bound." << std::endl;
+        }
+        sizeNodeArena(); // The route found is kept in an arena block, like the routes of the branch-and-bound search
+        heldKarpDispatcher();
+        return true;
+    }
+
+    programVariables.dominanceCache.reset(programVariables.dominanceCacheBytes);
+    if (!programVariables.resumePath.empty())
+    {
+        sizeNodeArena();
+        createWorkerQueues();
+        if (!resumeFromCheckpoint(programVariables.resumePath))
+        {
+            return false;
+        }
+        if (programVariables.warmStart && programVariables.bestRouteCost.load() == std::numeric_limits<double>::infinity())
+        {
+            seedFoundRouteWithHeuristic();
+        }
+    }
+    else
+    {
+        node root = initializeConfigurationMatrix(); 
+        if (programVariables.warmStart)
+        {
+            seedFoundRouteWithHeuristic();
+        }
+        createWorkerQueues();
+        pushUnprocessedNode(root, 0);
+    }
+    nodeExpansionDispatcher();
+    return true;
+}
+
+/*
+    Clears the instance and the results of the previous search so that another instance can be solved in the same process. The options 
+    (threads, bound, warm start, limits, checkpoint files, log level) are kept.
+*/
+void TravelingSalesmanSolver::resetProgramVariables()
+{
+    programVariables.workerQueues.clear();
+    programVariables.nodeArena.reset(0, 0); // Frees the chunks of the previous search now rather than when the next one sizes the arena
+    programVariables.outstandingNodes = 0;
+    programVariables.peakOutstandingNodes = 0;
+    programVariables.adjacencyMatrix.clear();
+    programVariables.foundRoute.lowerBound = std::numeric_limits<double>::infinity();
+    programVariables.bestRouteCost = std::numeric_limits<double>::infinity();
+    programVariables.endProgram = false;
+    programVariables.numberOfCitiesToVisit = 0;
+    programVariables.edgeWeightType = EXPLICIT_WEIGHTS;
+    programVariables.cityCoordinates.clear();
+    programVariables.nodesExpanded = 0;
+    programVariables.searchCounters.clear();
+    programVariables.stoppedByLimit = false;
+    programVariables.provenLowerBound = std::numeric_limits<double>::infinity();
+    programVariables.checkpointRequested = false;
+    programVariables.runningWorkers = 0;
+    programVariables.pausedWorkers = 0;
+    programVariables.nodesExpandedBeforeResume = 0;
+    programVariables.millisecondsBeforeResume = 0;
+    programVariables.firstRouteMilliseconds = -1;
+    programVariables.bestRouteMilliseconds = -1;
+    programVariables.searchMilliseconds = 0;
+    programVariables.solveMilliseconds = 0;
+    programVariables.heuristicRoute.clear();
+    programVariables.routeHistory.clear();
+    programVariables.restartsCompleted = 0;
+    programVariables.dominanceCache.reset(0);
+}
+
+/*
+    The configurationMatrix is a 2D matrix associated with each node. The size of the matrix depends on the numberOfCities that will be used in 
+    the simulation. For example, if the user chose the 5-city simulation, the 2D matrix will be of size [5][7]. The 5 x 5 part of the matrix contains 
+    either '0', '1', or '-1'. A cell will contain '1' if the edge has been included in the node's current route, and '-1' if the edge has been excluded 
+    (meaning that edge is not in the route). It was stated that the size of the 5-city 2D configurationMatrix for a node is [5][7], and this is because
+    two extra columns are needed to hold information to decipher whether an edge for that row can be included or excluded. The decision is made with the 
+    information in each of these last two columns.
+
+    The method below initializes the configurationMatrix for the root node. To continue with the 5-city example, this method will set the 5 x 5 cells to all '0s'. The last
+    column will be set to all '4s', and the 2nd to last column will again be set to all '0s'. More information can be found in the readME file.
+
+    The matrix is stored compactly in an arena block (see Configuration), so this method also sizes the NodeArena for the number of cities.
+*/
+node TravelingSalesmanSolver::initializeConfigurationMatrix()
+{
+    node root;
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+
+    sizeNodeArena();
+    root.configurationSlot = programVariables.nodeArena.allocate(0);
+
+    Configuration configuration = configurationOf(root);
+    for(int row = 0; row < numberOfCities; row++)
+    {
+        configuration.includedEdges[row] = 0;
+        configuration.excludedEdges[row] = 0;
+        configuration.includeColumn[row] = 0;
+        configuration.excludeColumn[row] = numberOfCities - 1;
+        configuration.fragmentEnd[row] = row; // Every city starts as a fragment of its own
+    }
+
+    root.constraint.first = 0;
+    root.constraint.second = 0;
+    root.include = false;
+    root.exclude = false;
+    root.includedEdgeCount = 0;
+    if (configuration.penalties != NULL)
+    {
+        std::fill(configuration.penalties, configuration.penalties + numberOfCities, 0.0);
+    }
+    calculateLowerBoundForNode(root);
+    if (programVariables.boundType == ONE_TREE_BOUND)
+    {
+        calculateOneTreeBound(root, ROOT_SUBGRADIENT_ITERATIONS, 0);
+    }
+    addToCounter(programVariables.searchCounters[0]->nodesCreated, 1);
+
+    return root;
+}
+
+/*
+    Sizes the NodeArena for the configurationMatrix of the current instance (see configurationOf() for the layout of a block). Blocks from a 
+    previous search are dropped.
+*/
+void TravelingSalesmanSolver::sizeNodeArena()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    int bytesPerBlock = numberOfCities * (2 * sizeof(RowMask) + sizeof(int) + 3 * sizeof(uint8_t)) + sizeof(int);
+    if (programVariables.boundType == ONE_TREE_BOUND)
+    {
+        bytesPerBlock += numberOfCities * sizeof(double);
+    }
+    bytesPerBlock = (bytesPerBlock + sizeof(RowMask) - 1) / sizeof(RowMask) * sizeof(RowMask); // Keeps every block's masks 8-byte aligned
+
+    programVariables.nodeArena.reset(bytesPerBlock, programVariables.numberOfThreads + 1); // The extra cache is for the receiving thread of a distributed worker
+}
+
+/*
+    Returns pointers into the arena block of a node. The block is laid out as 
+    [includedEdges | excludedEdges | penalties | rowLowerBound | lowerBoundTotal | includeColumn | excludeColumn | fragmentEnd], each array having one entry per city.
+    The penalties are only present with the 1-tree bound.
+*/
+Configuration TravelingSalesmanSolver::configurationOf(const node &nodeX)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    unsigned char *block = programVariables.nodeArena.block(nodeX.configurationSlot);
+    Configuration configuration;
+
+    configuration.includedEdges = reinterpret_cast<RowMask *>(block);
+    configuration.excludedEdges = configuration.includedEdges + numberOfCities;
+    configuration.penalties = NULL;
+    unsigned char *afterMasks = reinterpret_cast<unsigned char *>(configuration.excludedEdges + numberOfCities);
+    if (programVariables.boundType == ONE_TREE_BOUND)
+    {
+        configuration.penalties = reinterpret_cast<double *>(afterMasks);
+        afterMasks += numberOfCities * sizeof(double);
+    }
+    configuration.rowLowerBound = reinterpret_cast<int *>(afterMasks);
+    configuration.lowerBoundTotal = configuration.rowLowerBound + numberOfCities;
+    configuration.includeColumn = reinterpret_cast<uint8_t *>(configuration.lowerBoundTotal + 1);
+    configuration.excludeColumn = configuration.includeColumn + numberOfCities;
+    configuration.fragmentEnd = configuration.excludeColumn + numberOfCities;
+
+    return configuration;
+}
+
+/*
+    Copies a node into a freshly allocated arena block. Used when a popped node has both an include and an exclude child; the exclude child 
+    keeps the popped node's block, so only the include child pays for a copy.
+*/
+node TravelingSalesmanSolver::cloneNode(const node &nodeX, int id)
+{
+    node copy = nodeX;
+    copy.configurationSlot = programVariables.nodeArena.allocate(id);
+    std::memcpy(programVariables.nodeArena.block(copy.configurationSlot), programVariables.nodeArena.block(nodeX.configurationSlot), programVariables.nodeArena.bytesPerBlock());
+    return copy;
+}
+
+/*
+    Sizes the arena for blocks of bytesPerBlock bytes. Chunks from a previous search are dropped.
+*/
+void NodeArena::reset(int bytesPerBlock, int numberOfWorkers)
+{
+    std::lock_guard<std::mutex> lock(arenaMutex);
+
+    blockBytes = bytesPerBlock;
+    nextSlot = 0;
+    for (uint32_t i = 0; i < MAX_CHUNKS; i++)
+    {
+        chunks[i].reset();
+    }
+    sharedFreeSlots.clear();
+    workerFreeSlots.assign(numberOfWorkers, std::vector<uint32_t>());
+    for (int i = 0; i < numberOfWorkers; i++)
+    {
+        workerFreeSlots[i].reserve(2 * SLOT_BATCH);
+    }
+}
+
+/*
+    Hands out a free slot. The worker's own cache is used first; when it is empty, a batch of slots is taken from the shared free list, or 
+    carved out of the current chunk (allocating a new chunk when the current one is used up).
+*/
+uint32_t NodeArena::allocate(int id)
+{
+    std::vector<uint32_t> &freeSlots = workerFreeSlots[id];
+
+    if (freeSlots.empty())
+    {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+
+        while (freeSlots.size() < SLOT_BATCH && !sharedFreeSlots.empty())
+        {
+            freeSlots.push_back(sharedFreeSlots.back());
+            sharedFreeSlots.pop_back();
+        }
+        while (freeSlots.size() < SLOT_BATCH)
+        {
+            uint32_t chunk = nextSlot / BLOCKS_PER_CHUNK;
+            if (chunk >= MAX_CHUNKS)
+            {
+                break;
+            }
+            if (!chunks[chunk])
+            {
+                chunks[chunk].reset(new unsigned char[(size_t)BLOCKS_PER_CHUNK * blockBytes]);
+            }
+            freeSlots.push_back(nextSlot++);
+        }
+        if (freeSlots.empty())
+        {
+            std::cout << "Out of memory for nodes; the search cannot continue." << std::endl;
+            std::abort();
+        }
+    }
+
+    uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+/*
+    Returns a slot to the worker's cache. When the cache grows past two batches, one batch is handed back to the shared free list so that 
+    slots freed by one worker can be reused by the others.
+*/
+void NodeArena::release(uint32_t slot, int id)
+{
+    std::vector<uint32_t> &freeSlots = workerFreeSlots[id];
+    freeSlots.push_back(slot);
+
+    if (freeSlots.size() >= 2 * SLOT_BATCH)
+    {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        for (size_t i = 0; i < SLOT_BATCH; i++)
+        {
+            sharedFreeSlots.push_back(freeSlots.back());
+            freeSlots.pop_back();
+        }
+    }
+}
+
+/*
+    Opens the trace file, creates one ring per worker and starts the drain thread. Returns false if the file cannot be opened.
+*/
+bool TraceLog::start(const std::string &path, int numberOfWorkers)
+{
+    file = std::fopen(path.c_str(), "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    rings.clear();
+    for (int i = 0; i < numberOfWorkers; i++)
+    {
+        rings.push_back(std::unique_ptr<Ring>(new Ring()));
+    }
+    startTime = std::chrono::steady_clock::now();
+    stopDraining = false;
+    drainThread = std::thread(&TraceLog::drainLoop, this);
+    return true;
+}
+
+/*
+    Stops the drain thread once every ring is empty, and closes the trace file.
+*/
+void TraceLog::stop()
+{
+    stopDraining = true;
+    drainThread.join();
+    std::fclose(file);
+    file = NULL;
+}
+
+/*
+    Appends a record to the worker's ring. This is the only part of tracing that runs on a worker: a timestamp and a 24-byte copy.
+*/
+void TraceLog::record(int id, TraceEvent event, const node &nodeX)
+{
+    Ring &ring = *rings[id];
+    uint64_t written = ring.written.load(std::memory_order_relaxed);
+
+    while (written - ring.drained.load(std::memory_order_acquire) >= RING_CAPACITY) // Full; wait for the drain thread to catch up
+    {
+        std::this_thread::yield();
+    }
+
+    TraceRecord &record = ring.records[written & (RING_CAPACITY - 1)];
+    record.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    record.lowerBound = nodeX.lowerBound;
+    record.worker = id;
+    record.event = event;
+    record.row = nodeX.constraint.first;
+    record.column = nodeX.constraint.second;
+    ring.written.store(written + 1, std::memory_order_release);
+}
+
+void TraceLog::drainLoop()
+{
+    while (true)
+    {
+        bool stopping = stopDraining.load(); // Read before draining, so records appended before stop() are always written
+        bool drainedAny = drainRings();
+        if (stopping && !drainedAny)
+        {
+            break;
+        }
+        if (!drainedAny)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::fflush(file);
+}
+
+/*
+    Formats and writes every record currently in the rings. Returns true if any record was written.
+*/
+bool TraceLog::drainRings()
+{
+    bool drainedAny = false;
+
+    for (size_t i = 0; i < rings.size(); i++)
+    {
+        Ring &ring = *rings[i];
+        uint64_t drained = ring.drained.load(std::memory_order_relaxed);
+        uint64_t written = ring.written.load(std::memory_order_acquire);
+
+        for (; drained < written; drained++)
+        {
+            const TraceRecord &record = ring.records[drained & (RING_CAPACITY - 1)];
+            std::fprintf(file, "%12.6f ms  worker %2d  %-16s <%d><%d>  lowerbound %g\n", record.nanoseconds / 1e6, int(record.worker), 
+                traceEventToString(TraceEvent(record.event)), int(record.row), int(record.column), record.lowerBound);
+            drainedAny = true;
+        }
+        ring.drained.store(drained, std::memory_order_release);
+    }
+
+    return drainedAny;
+}
+
+const char *traceEventToString(TraceEvent event)
+{
+    switch (event)
+    {
+        case TRACE_INCLUDED: return "included";
+        case TRACE_EXCLUDED: return "excluded";
+        case TRACE_CANNOT_INCLUDE: return "cannot include";
+        case TRACE_CANNOT_EXCLUDE: return "cannot exclude";
+        case TRACE_PRUNED: return "pruned";
+        case TRACE_ROUTE_FOUND: return "route found";
+        default: return "";
+    }
+}
+
+/*
+    Depending on whether the user chose to run the 5-city, 6-city, or 7-city simulation, the adjacencyMatrix (a global 2D matrix containing costs to travel from city to city)
+    will be set. A cell in the adjacencyMatrix can be interpreted as such: [x][y] would correspond to the cost of traveling from city x to city y. The values 
+    for each of the simulations are trivial and randomly chosen. It's also important to note [x][x] is 0 for all cities, meaning the cost to travel from 
+    a city to itself is 0.
+*/
+void TravelingSalesmanSolver::setAdjacencyMatrix()
+{
+    if(programVariables.numberOfCitiesToVisit == 5)
+    {
+        std::vector<std::vector<int> > fiveCitySimulation {
+        {0, 3, 4, 2, 7},    
+        {3, 0, 4, 6, 3},    
+        {4, 4, 0, 5, 8},    
+        {2, 6, 5, 0, 6},    
+        {7, 3, 8, 6, 0}     
+    };
+
+        programVariables.adjacencyMatrix.assign(fiveCitySimulation);
+    }
+
+    else if(programVariables.numberOfCitiesToVisit == 6)
+    {
+        std::vector<std::vector<int> > sixCitySimulation {
+        {0, 2, 4, 1, 7, 2},   
+        {3, 0, 2, 7, 3, 4},   
+        {4, 9, 0, 7, 8, 2},   
+        {2, 9, 5, 0, 6, 6},   
+        {7, 9, 8, 7, 0, 2},   
+        {3, 9, 5, 7, 2, 0},           
+    };
+        programVariables.adjacencyMatrix.assign(sixCitySimulation);
+    }
+    else
+    {
+        std::vector<std::vector<int> > sevenCitySimulation {
+        {0, 6, 8, 2, 6, 1, 9},   
+        {6, 0, 5, 4, 1, 9, 2},   
+        {8, 5, 0, 6, 1, 1, 8},   
+        {2, 4, 6, 0, 2, 9, 3},   
+        {6, 1, 1, 2, 0, 2, 9},   
+        {1, 9, 1, 9, 2, 0, 7},
+        {9, 2, 8, 3, 9, 7, 0}, 
+
+    };
+    programVariables.adjacencyMatrix.assign(sevenCitySimulation);
+    }
+}
+
+/*
+    Read-only view of a whole file, mapped into memory rather than read through a stream. The mapping is released when the object goes out of scope.
+*/
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) : contents(NULL), length(0)
+    {
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        mappingHandle = NULL;
+        LARGE_INTEGER size;
+        if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+        {
+            return;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle != NULL)
+        {
+            contents = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            length = contents != NULL ? size_t(size.QuadPart) : 0;
+        }
+#else
+        int descriptor = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (descriptor < 0)
+        {
+            return;
+        }
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping != MAP_FAILED)
+            {
+                madvise(mapping, status.st_size, MADV_SEQUENTIAL); // The file is parsed once, front to back
+                contents = static_cast<const char *>(mapping);
+                length = status.st_size;
+            }
+        }
+        close(descriptor); // The mapping stays valid after the descriptor is closed
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (contents != NULL) UnmapViewOfFile(contents);
+        if (mappingHandle != NULL) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+#else
+        if (contents != NULL) munmap(const_cast<char *>(contents), length);
+#endif
+    }
+
+    const char *contents;
+    size_t length;
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+};
+
+/*
+    Opens a socket for an address given on the command line: "unix:PATH" for a Unix domain socket (not on Windows), "HOST:PORT" or "PORT" 
+    for TCP. A listening socket is bound to the address (an empty HOST listens on every interface), any other is connected to it (HOST 
+    defaults to localhost). Returns NO_SOCKET if that fails.
+*/
+SocketHandle openSocket(const std::string &address, bool listening)
+{
+#ifdef _WIN32
+    static bool started = false;
+    WSADATA data;
+    if (!started && WSAStartup(MAKEWORD(2, 2), &data) == 0)
+    {
+        started = true;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN); // A peer that has gone away shows up as a failed send, not a signal
+#endif
+
+    if (address.compare(0, 5, "unix:") == 0)
+    {
+#ifdef _WIN32
+        return NO_SOCKET;
+#else
+        std::string path = address.substr(5);
+        sockaddr_un socketAddress = sockaddr_un();
+        socketAddress.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(socketAddress.sun_path))
+        {
+            return NO_SOCKET;
+        }
+        std::strcpy(socketAddress.sun_path, path.c_str());
+        SocketHandle handle = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listening)
+        {
+            unlink(path.c_str()); // A socket file left by an earlier coordinator would make bind() fail
+        }
+        bool opened = handle != NO_SOCKET && (listening 
+            ? bind(handle, reinterpret_cast<sockaddr *>(&socketAddress), sizeof(socketAddress)) == 0 && listen(handle, SOMAXCONN) == 0
+            : connect(handle, reinterpret_cast<sockaddr *>(&socketAddress), sizeof(socketAddress)) == 0);
+        if (!opened && handle != NO_SOCKET)
+        {
+            closeSocket(handle);
+            handle = NO_SOCKET;
+        }
+        return handle;
+#endif
+    }
+
+    size_t colon = address.rfind(':');
+    std::string host = colon == std::string::npos ? "" : address.substr(0, colon);
+    std::string port = colon == std::string::npos ? address : address.substr(colon + 1);
+    if (host.empty() && !listening)
+    {
+        host = "localhost";
+    }
+    addrinfo hints = addrinfo();
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    addrinfo *results = NULL;
+    if (getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &results) != 0)
+    {
+        return NO_SOCKET;
+    }
+
+    SocketHandle handle = NO_SOCKET;
+    for (addrinfo *result = results; result != NULL && handle == NO_SOCKET; result = result->ai_next)
+    {
+        handle = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (handle == NO_SOCKET)
+        {
+            continue;
+        }
+        int on = 1;
+        bool opened;
+        if (listening)
+        {
+            setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+            opened = bind(handle, result->ai_addr, result->ai_addrlen) == 0 && listen(handle, SOMAXCONN) == 0;
+        }
+        else
+        {
+            opened = connect(handle, result->ai_addr, result->ai_addrlen) == 0;
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&on), sizeof(on)); // Most messages are a few bytes
+        }
+        if (!opened)
+        {
+            closeSocket(handle);
+            handle = NO_SOCKET;
+        }
+    }
+    freeaddrinfo(results);
+    return handle;
+}
+
+/*
+    Accepts the next connection on a listening socket. Returns NO_SOCKET if that fails.
+*/
+SocketHandle acceptSocket(SocketHandle listener)
+{
+    SocketHandle handle = accept(listener, NULL, NULL);
+    if (handle != NO_SOCKET)
+    {
+        int on = 1;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&on), sizeof(on)); // Fails harmlessly on a Unix domain socket
+    }
+    return handle;
+}
+
+/*
+    One end of a connection between the coordinator and a worker process of a distributed search. Every message is a type and a payload 
+    length (two uint32_t) followed by the payload. Any thread may send, as sends are serialized by sendMutex; only one thread receives.
+    The socket is closed when the object goes out of scope.
+*/
+class MessageSocket {
+public:
+    explicit MessageSocket(SocketHandle handle) : handle(handle) {}
+    ~MessageSocket()
+    {
+        if (handle != NO_SOCKET) closeSocket(handle);
+    }
+
+    bool send(uint32_t type, const std::vector<unsigned char> &payload)
+    {
+        std::vector<unsigned char> message(2 * sizeof(uint32_t) + payload.size());
+        uint32_t header[2] = { type, uint32_t(payload.size()) };
+        std::memcpy(&message[0], header, sizeof(header));
+        if (!payload.empty())
+        {
+            std::memcpy(&message[sizeof(header)], payload.data(), payload.size());
+        }
+
+        std::lock_guard<std::mutex> lock(sendMutex);
+        for (size_t sent = 0; sent < message.size(); )
+        {
+            long result = ::send(handle, reinterpret_cast<const char *>(&message[sent]), int(message.size() - sent), 0);
+            if (result <= 0)
+            {
+                return false;
+            }
+            sent += result;
+        }
+        return true;
+    }
+
+    // Waits for the next message. Returns false once the connection is closed or broken.
+    bool receive(uint32_t &type, std::vector<unsigned char> &payload)
+    {
+        uint32_t header[2];
+        if (!receiveBytes(reinterpret_cast<unsigned char *>(header), sizeof(header)) || header[1] > MAX_MESSAGE_BYTES)
+        {
+            return false;
+        }
+        type = header[0];
+        payload.resize(header[1]);
+        return payload.empty() || receiveBytes(&payload[0], payload.size());
+    }
+
+    SocketHandle handle;
+
+private:
+    static const uint32_t MAX_MESSAGE_BYTES = 1u << 30; // A longer message means the peer is not speaking this protocol
+
+    bool receiveBytes(unsigned char *bytes, size_t length)
+    {
+        for (size_t received = 0; received < length; )
+        {
+            long result = recv(handle, reinterpret_cast<char *>(bytes + received), int(length - received), 0);
+            if (result <= 0)
+            {
+                return false;
+            }
+            received += result;
+        }
+        return true;
+    }
+
+    MessageSocket(const MessageSocket &);
+    MessageSocket &operator=(const MessageSocket &);
+    std::mutex sendMutex;
+};
+
+/*
+    Tokenizer over a mapped file. The mapping is not null-terminated, so every read is bounded by end; numbers are parsed by hand for the 
+    same reason (and to avoid the per-token overhead of streams).
+*/
+struct InstanceScanner {
+    const char *position;
+    const char *end;
+
+    bool atEnd() 
+    { 
+        skipSpaces(); 
+        return position >= end; 
+    }
+
+    void skipSpaces()
+    {
+        while (position < end && (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n'))
+        {
+            position++;
+        }
+    }
+
+    // Reads a run of characters up to whitespace or ':' (TSPLIB keywords may be written "KEY: VALUE" or "KEY : VALUE")
+    std::string readWord()
+    {
+        skipSpaces();
+        const char *start = position;
+        while (position < end && *position != ' ' && *position != '\t' && *position != '\r' && *position != '\n' && *position != ':')
+        {
+            position++;
+        }
+        return std::string(start, position);
+    }
+
+    // Returns the rest of the current line, without the leading ':' and surrounding spaces
+    std::string readLineValue()
+    {
+        while (position < end && (*position == ' ' || *position == '\t' || *position == ':'))
+        {
+            position++;
+        }
+        const char *start = position;
+        while (position < end && *position != '\n')
+        {
+            position++;
+        }
+        const char *last = position;
+        while (last > start && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+        {
+            last--;
+        }
+        return std::string(start, last);
+    }
+
+    // Whether the rest of the file is long enough for the given count of numbers (a digit and a separator each), so a section's storage 
+    // is only allocated for a dimension the file can actually fill
+    bool canHold(long long numbers) const
+    {
+        return end - position >= 2 * numbers - 1;
+    }
+
+    bool peekNumber()
+    {
+        skipSpaces();
+        return position < end && ((*position >= '0' && *position <= '9') || *position == '-' || *position == '+' || *position == '.');
+    }
+
+    bool readDouble(double &value)
+    {
+        if (!peekNumber())
+        {
+            return false;
+        }
+        bool negative = *position == '-';
+        if (*position == '-' || *position == '+')
+        {
+            position++;
+        }
+        double result = 0;
+        bool anyDigits = false;
+        while (position < end && *position >= '0' && *position <= '9')
+        {
+            result = result * 10 + (*position++ - '0');
+            anyDigits = true;
+        }
+        if (position < end && *position == '.')
+        {
+            position++;
+            double scale = 0.1;
+            while (position < end && *position >= '0' && *position <= '9')
+            {
+                result += (*position++ - '0') * scale;
+                scale /= 10;
+                anyDigits = true;
+            }
+        }
+        if (position < end && (*position == 'e' || *position == 'E'))
+        {
+            position++;
+            bool negativeExponent = position < end && *position == '-';
+            if (position < end && (*position == '-' || *position == '+'))
+            {
+                position++;
+            }
+            int exponent = 0;
+            while (position < end && *position >= '0' && *position <= '9')
+            {
+                exponent = exponent * 10 + (*position++ - '0');
+            }
+            result *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+        }
+        value = negative ? -result : result;
+        return anyDigits;
+    }
+
+    bool readInt(int &value)
+    {
+        double number;
+        if (!readDouble(number) || std::fabs(number) >= std::numeric_limits<int>::max())
+        {
+            return false;
+        }
+        value = int(number + (number < 0 ? -0.5 : 0.5)); // Some files write whole costs as "12.0"
+        return true;
+    }
+};
+
+/*
+    Loads an instance from a file, without any interaction. Two formats are accepted:
+
+    - TSPLIB (TSP, or ATSP with a symmetric matrix). Costs may be given EXPLICIT (FULL_MATRIX and every row/column, upper/lower, with/without 
+      diagonal layout), or derived from NODE_COORD_SECTION coordinates with EUC_2D, CEIL_2D, ATT or GEO distances. Coordinate instances only 
+      keep the coordinates here; solveLoadedInstance() builds the adjacencyMatrix once it knows the solver can take the instance. The 
+      coordinates of an EXPLICIT instance are only display data and are dropped, so the EDGE_WEIGHT_SECTION costs are the ones solved.
+    - A plain matrix: the number of cities followed by the full cost matrix, row by row.
+
+    Explicit costs are kept as a full matrix for instances the exact engines can take (up to MAX_CITIES cities) and as the upper triangle 
+    beyond that (see DistanceOracle). Cities are numbered by their index in the file, starting at 0. Returns false (after printing the reason 
+    to stderr, which keeps it out of the rows of a batch) if the file cannot be used.
+
+    The number of cities must be from 1 to MAX_CITIES, or to MAX_INSTANCE_CITIES when the engine may be Lin-Kernighan (lk or auto). A TSPLIB 
+    DIMENSION must come before the sections, and every section must be read with the final DIMENSION.
+*/
+bool TravelingSalesmanSolver::loadInstanceFile(const std::string &path)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    if (file.contents == NULL)
+    {
+        std::cerr << "Could not open or map '" << path << "'." << std::endl;
+        return false;
+    }
+
+    InstanceScanner scanner = { file.contents, file.contents + file.length };
+    DistanceOracle &adjacencyMatrix = programVariables.adjacencyMatrix;
+    int numberOfCities = 0;
+    int largestInstance = programVariables.engine == AUTO_ENGINE || programVariables.engine == LIN_KERNIGHAN_ENGINE ? MAX_INSTANCE_CITIES : MAX_CITIES;
+
+    adjacencyMatrix.clear();
+    programVariables.cityCoordinates.clear();
+    programVariables.edgeWeightType = EXPLICIT_WEIGHTS;
+
+    if (scanner.peekNumber()) // Plain matrix
+    {
+        if (!scanner.readInt(numberOfCities) || numberOfCities <= 0 || numberOfCities > largestInstance)
+        {
+            std::cerr << "'" << path << "' does not start with a number of cities from 1 to " << largestInstance << "." << std::endl;
+            return false;
+        }
+        if (!scanner.canHold((long long)numberOfCities * numberOfCities))
+        {
+            std::cerr << "'" << path << "' is too short for a " << numberOfCities << " x " << numberOfCities << " matrix." << std::endl;
+            return false;
+        }
+        adjacencyMatrix.assign(numberOfCities, numberOfCities > MAX_CITIES ? NARROW_TRIANGULAR_DISTANCES : FULL_DISTANCES);
+        for (int row = 0; row < numberOfCities; row++)
+        {
+            for (int column = 0; column < numberOfCities; column++)
+            {
+                int cost;
+                if (!scanner.readInt(cost))
+                {
+                    std::cerr << "'" << path << "' ends before its " << numberOfCities << " x " << numberOfCities << " matrix is complete." << std::endl;
+                    return false;
+                }
+                adjacencyMatrix.set(row, column, cost);
+            }
+        }
+    }
+    else // TSPLIB
+    {
+        std::string weightFormat = "FULL_MATRIX";
+        bool haveCoordinates = false;
+        bool haveMatrix = false;
+        bool asymmetricType = false;
+        bool asymmetricCosts = false; // A FULL_MATRIX cost differs from its mirror image
+        int sectionCities = 0; // DIMENSION the sections read so far were read with
+
+        while (!scanner.atEnd())
+        {
+            std::string keyword = scanner.readWord();
+
+            if ((keyword == "NODE_COORD_SECTION" || keyword == "EDGE_WEIGHT_SECTION" || keyword == "DISPLAY_DATA_SECTION") && numberOfCities == 0)
+            {
+                std::cerr << keyword << " of '" << path << "' comes before its DIMENSION." << std::endl;
+                return false;
+            }
+
+            if (keyword == "DIMENSION")
+            {
+                std::string value = scanner.readLineValue();
+                char *rest;
+                long dimension = std::strtol(value.c_str(), &rest, 10);
+                if (value.empty() || *rest != '\0' || dimension <= 0 || dimension > largestInstance)
+                {
+                    std::cerr << "DIMENSION " << value << " of '" << path << "' is not a number of cities from 1 to " << largestInstance << "." << std::endl;
+                    return false;
+                }
+                numberOfCities = int(dimension);
+            }
+            else if (keyword == "EDGE_WEIGHT_TYPE")
+            {
+                std::string type = scanner.readLineValue();
+                if (type == "EXPLICIT") programVariables.edgeWeightType = EXPLICIT_WEIGHTS;
+                else if (type == "EUC_2D") programVariables.edgeWeightType = EUC_2D_WEIGHTS;
+                else if (type == "CEIL_2D") programVariables.edgeWeightType = CEIL_2D_WEIGHTS;
+                else if (type == "ATT") programVariables.edgeWeightType = ATT_WEIGHTS;
+                else if (type == "GEO") programVariables.edgeWeightType = GEO_WEIGHTS;
+                else
+                {
+                    std::cerr << "EDGE_WEIGHT_TYPE " << type << " is not supported." << std::endl;
+                    return false;
+                }
+            }
+            else if (keyword == "EDGE_WEIGHT_FORMAT")
+            {
+                weightFormat = scanner.readLineValue();
+            }
+            else if (keyword == "TYPE")
+            {
+                std::string type = scanner.readLineValue();
+                asymmetricType = type == "ATSP";
+                if (type != "TSP" && type != "ATSP")
+                {
+                    std::cerr << "TYPE " << type << " is not supported." << std::endl;
+                    return false;
+                }
+            }
+            else if (keyword == "NODE_COORD_SECTION")
+            {
+                if (!scanner.canHold(3LL * numberOfCities))
+                {
+                    std::cerr << "NODE_COORD_SECTION of '" << path << "' is too short for " << numberOfCities << " cities." << std::endl;
+                    return false;
+                }
+                programVariables.cityCoordinates.resize(numberOfCities);
+                for (int city = 0; city < numberOfCities; city++)
+                {
+                    int label;
+                    if (!scanner.readInt(label) || !scanner.readDouble(programVariables.cityCoordinates[city].first) || !scanner.readDouble(programVariables.cityCoordinates[city].second))
+                    {
+                        std::cerr << "NODE_COORD_SECTION of '" << path << "' ends before city " << city << "." << std::endl;
+                        return false;
+                    }
+                }
+                haveCoordinates = true;
+                sectionCities = numberOfCities;
+            }
+            else if (keyword == "EDGE_WEIGHT_SECTION")
+            {
+                // Each layout is read as a sequence of rows; a column-wise layout of a symmetric matrix is the same as the opposite row-wise layout
+                bool upper = weightFormat == "UPPER_ROW" || weightFormat == "UPPER_DIAG_ROW" || weightFormat == "LOWER_COL" || weightFormat == "LOWER_DIAG_COL";
+                bool lower = weightFormat == "LOWER_ROW" || weightFormat == "LOWER_DIAG_ROW" || weightFormat == "UPPER_COL" || weightFormat == "UPPER_DIAG_COL";
+                bool diagonal = weightFormat.find("DIAG") != std::string::npos;
+                if (!upper && !lower && weightFormat != "FULL_MATRIX")
+                {
+                    std::cerr << "EDGE_WEIGHT_FORMAT " << weightFormat << " is not supported." << std::endl;
+                    return false;
+                }
+                if (!scanner.canHold(upper || lower ? (long long)numberOfCities * (numberOfCities - 1) / 2 : (long long)numberOfCities * numberOfCities))
+                {
+                    std::cerr << "EDGE_WEIGHT_SECTION of '" << path << "' is too short for " << numberOfCities << " cities." << std::endl;
+                    return false;
+                }
+
+                adjacencyMatrix.assign(numberOfCities, numberOfCities > MAX_CITIES ? NARROW_TRIANGULAR_DISTANCES : FULL_DISTANCES);
+                for (int row = 0; row < numberOfCities; row++)
+                {
+                    int first = upper ? (diagonal ? row : row + 1) : 0;
+                    int last = lower ? (diagonal ? row : row - 1) : numberOfCities - 1;
+                    for (int column = first; column <= last; column++)
+                    {
+                        int cost;
+                        if (!scanner.readInt(cost))
+                        {
+                            std::cerr << "EDGE_WEIGHT_SECTION of '" << path << "' ends early." << std::endl;
+                            return false;
+                        }
+                        asymmetricCosts = asymmetricCosts || (!upper && !lower && column < row && adjacencyMatrix.distance(column, row) != cost);
+                        adjacencyMatrix.set(row, column, cost);
+                        if (upper || lower)
+                        {
+                            adjacencyMatrix.set(column, row, cost);
+                        }
+                    }
+                }
+                haveMatrix = true;
+                sectionCities = numberOfCities;
+            }
+            else if (keyword == "EOF")
+            {
+                break;
+            }
+            else if (keyword == "DISPLAY_DATA_SECTION")
+            {
+                for (int i = 0; i < 3 * numberOfCities; i++) // Label and two coordinates per city, only used for drawing
+                {
+                    double ignored;
+                    scanner.readDouble(ignored);
+                }
+            }
+            else
+            {
+                scanner.readLineValue(); // NAME, COMMENT and any other keyword the solver does not need
+            }
+        }
+
+        if (programVariables.edgeWeightType == EXPLICIT_WEIGHTS)
+        {
+            programVariables.cityCoordinates.clear(); // Display data; a coordinate instance has no EXPLICIT type
+            haveCoordinates = false;
+        }
+        if (numberOfCities <= 0 || (!haveMatrix && !haveCoordinates))
+        {
+            std::cerr << "'" << path << "' does not define a DIMENSION and its edge weights." << std::endl;
+            return false;
+        }
+        if (sectionCities != numberOfCities)
+        {
+            std::cerr << "'" << path << "' changes its DIMENSION from " << sectionCities << " to " << numberOfCities << " after a section." << std::endl;
+            return false;
+        }
+        if (asymmetricType && asymmetricCosts)
+        {
+            std::cerr << "'" << path << "' is an ATSP instance with an asymmetric matrix. The solver treats edges as undirected, so it would "
+                "solve a different instance and report a cost that is not the ATSP cost." << std::endl;
+            return false;
+        }
+    }
+
+    programVariables.numberOfCitiesToVisit = numberOfCities;
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Loaded " << numberOfCities << " cities from '" << path << "' in " 
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms." << std::endl;
+    }
+    return true;
+}
+
+/*
+    Fills the adjacencyMatrix of a coordinate instance, row by row, using the TSPLIB distance function of the instance.
+*/
+void TravelingSalesmanSolver::buildAdjacencyMatrixFromCoordinates()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    const std::vector<std::pair<double, double> > &coordinates = programVariables.cityCoordinates;
+    programVariables.adjacencyMatrix.assign(numberOfCities);
+
+    for (int row = 0; row < numberOfCities; row++)
+    {
+        for (int column = row + 1; column < numberOfCities; column++)
+        {
+            int cost = coordinateDistance(coordinates[row], coordinates[column], programVariables.edgeWeightType);
+            programVariables.adjacencyMatrix[row][column] = programVariables.adjacencyMatrix[column][row] = cost;
+        }
+    }
+}
+
+/*
+    Distance between two cities of a coordinate instance, rounded the way TSPLIB specifies for the instance's EDGE_WEIGHT_TYPE.
+*/
+int coordinateDistance(const std::pair<double, double> &a, const std::pair<double, double> &b, EdgeWeightType type)
+{
+    double dx = a.first - b.first;
+    double dy = a.second - b.second;
+
+    switch (type)
+    {
+        case CEIL_2D_WEIGHTS:
+            return int(std::ceil(std::sqrt(dx * dx + dy * dy)));
+        case ATT_WEIGHTS:
+        {
+            double distance = std::sqrt((dx * dx + dy * dy) / 10.0);
+            int rounded = int(distance + 0.5);
+            return rounded < distance ? rounded + 1 : rounded;
+        }
+        case GEO_WEIGHTS:
+        {
+            // Coordinates are DDD.MM (degrees and minutes); converted to radians as in the TSPLIB documentation
+            const double PI = 3.141592;
+            const double RRR = 6378.388;
+            double latitudeA = PI * (int(a.first) + 5.0 * (a.first - int(a.first)) / 3.0) / 180.0;
+            double longitudeA = PI * (int(a.second) + 5.0 * (a.second - int(a.second)) / 3.0) / 180.0;
+            double latitudeB = PI * (int(b.first) + 5.0 * (b.first - int(b.first)) / 3.0) / 180.0;
+            double longitudeB = PI * (int(b.second) + 5.0 * (b.second - int(b.second)) / 3.0) / 180.0;
+            double q1 = std::cos(longitudeA - longitudeB);
+            double q2 = std::cos(latitudeA - latitudeB);
+            double q3 = std::cos(latitudeA + latitudeB);
+            return int(RRR * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+        }
+        default:
+            return int(std::sqrt(dx * dx + dy * dy) + 0.5);
+    }
+}
+
+/*
+    Makes room for the costs of a new instance of the given number of cities, all 0, in the given storage. COORDINATE_DISTANCES is set 
+    with useCoordinates() instead.
+*/
+void DistanceOracle::assign(int cities, DistanceStorage storageKind)
+{
+    storage = storageKind;
+    numberOfCities = cities;
+    coordinates = NULL;
+    size_t edges = size_t(cities) * (cities > 0 ? cities - 1 : 0) / 2;
+    std::vector<int>(storage == FULL_DISTANCES ? size_t(cities) * cities : 0, 0).swap(full); // swap() also gives back the memory of a larger instance
+    std::vector<int>(storage == TRIANGULAR_DISTANCES ? edges : 0, 0).swap(triangle);
+    std::vector<uint16_t>(storage == NARROW_TRIANGULAR_DISTANCES ? edges : 0, 0).swap(narrowTriangle);
+}
+
+/*
+    Copies a full matrix given as rows, such as the simulated instances of setAdjacencyMatrix().
+*/
+void DistanceOracle::assign(const std::vector<std::vector<int> > &rows)
+{
+    assign(int(rows.size()));
+    for (int row = 0; row < numberOfCities; row++)
+    {
+        std::copy(rows[row].begin(), rows[row].end(), (*this)[row]);
+    }
+}
+
+/*
+    Stops storing costs: each one is computed from the coordinates when asked for. The coordinates must outlive the oracle's use of them.
+*/
+void DistanceOracle::useCoordinates(const std::vector<std::pair<double, double> > *cityCoordinates, EdgeWeightType type)
+{
+    assign(int(cityCoordinates->size()), COORDINATE_DISTANCES);
+    coordinates = cityCoordinates;
+    weightType = type;
+}
+
+/*
+    Stores the cost of the edge from -> to. The triangular storages only keep the edges with from < to, the cost the solver charges for an 
+    undirected edge; the others are ignored. The 16-bit triangle is widened to 32 bits by the first cost outside 0..65535.
+*/
+void DistanceOracle::set(int from, int to, int cost)
+{
+    if (storage == FULL_DISTANCES)
+    {
+        full[size_t(from) * numberOfCities + to] = cost;
+        return;
+    }
+    if (from >= to || storage == COORDINATE_DISTANCES)
+    {
+        return;
+    }
+    if (storage == NARROW_TRIANGULAR_DISTANCES && (cost < 0 || cost > 0xFFFF))
+    {
+        triangle.assign(narrowTriangle.begin(), narrowTriangle.end());
+        std::vector<uint16_t>().swap(narrowTriangle);
+        storage = TRIANGULAR_DISTANCES;
+    }
+    if (storage == NARROW_TRIANGULAR_DISTANCES)
+    {
+        narrowTriangle[triangleIndex(from, to)] = uint16_t(cost);
+    }
+    else
+    {
+        triangle[triangleIndex(from, to)] = cost;
+    }
+}
+
+/*
+    The solver treats an edge as undirected and has always charged the cost found in the upper triangle of the adjacencyMatrix ([x][y] with x < y).
+    This method copies the upper triangle over the lower one, so that every row of the matrix lists the cost of each edge touching that city. 
+    The lower bound scans whole rows, so it relies on this.
+*/
+void TravelingSalesmanSolver::symmetrizeAdjacencyMatrix()
+{
+    if (programVariables.adjacencyMatrix.storageKind() != FULL_DISTANCES)
+    {
+        return; // Only the upper triangle is stored, and distance() already reads it for both directions
+    }
+    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
+    {
+        for (int column = 0; column < row; column++)
+        {
+            programVariables.adjacencyMatrix[row][column] = programVariables.adjacencyMatrix[column][row];
+        }
+    }
+}
+
+/*
+    Gives every worker an empty queue and depth-first stack. The queues must exist before the first node is pushed.
+*/
+void TravelingSalesmanSolver::createWorkerQueues()
+{
+    programVariables.workerQueues.clear();
+    for (int i = 0; i < programVariables.numberOfThreads; i++)
+    {
+        programVariables.workerQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+    programVariables.depthFirstStacks.assign(programVariables.numberOfThreads, DepthFirstStack());
+}
+
+/*
+    This dispatcher method starts a fixed pool of worker threads and waits for them to finish. Each worker runs the main program loop 
+    (see workerLoop()): a node is popped from the worker's own queue, or stolen from another worker when its own queue is empty, and is 
+    checked to see if it can be expanded further. If a node cannot be expanded, that node contains a route. It will then be used to prune 
+    nodes that contain higher lower bounds than it.
+
+    If a route is not found, it is determined whether the node can include or exclude another edge in that row. For each of the conditions that 
+    evaluate to true, another node that contains that include/excluded edge is created and added back into the worker's queue for further expansion.
+
+    The queues must already hold the root (or the nodes of a resumed checkpoint). With a checkpoint file, a checkpoint thread saves the search 
+    every checkpointSeconds (see checkpointLoop()), and the search is saved once more when it ends, finished or stopped by a limit.
+*/
+void TravelingSalesmanSolver::nodeExpansionDispatcher() 
+{
+    if (programVariables.logLevel == LOG_TRACE && !programVariables.traceLog.start(programVariables.traceLogPath, programVariables.numberOfThreads))
+    {
+        std::cerr << "Could not open trace file '" << programVariables.traceLogPath << "', tracing is disabled." << std::endl;
+        programVariables.logLevel = LOG_SUMMARY;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread progressThread;
+    if (programVariables.progressSeconds > 0)
+    {
+        progressThread = std::thread(&TravelingSalesmanSolver::progressLoop, this);
+    }
+    programVariables.runningWorkers = programVariables.numberOfThreads;
+    std::thread checkpointThread;
+    if (!programVariables.checkpointPath.empty())
+    {
+        checkpointThread = std::thread(&TravelingSalesmanSolver::checkpointLoop, this);
+    }
+    std::vector<std::thread> workers;
+    for (int id = 1; id < programVariables.numberOfThreads; id++)
+    {
+        workers.push_back(std::thread(&TravelingSalesmanSolver::workerLoop, this, id));
+    }
+    workerLoop(0); // The calling thread is worker 0, so a single-threaded solve (as in batch mode) starts no thread at all
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    if (progressThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(programVariables.progressMutex); // endProgram is already set; taking the lock means the wait cannot miss the wake-up
+        }
+        programVariables.progressCondition.notify_all();
+        progressThread.join();
+    }
+    if (checkpointThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(programVariables.checkpointMutex);
+        }
+        programVariables.checkpointCondition.notify_all();
+        checkpointThread.join();
+
+        std::vector<unsigned char> buffer; // Every worker is done, so the final checkpoint needs no pause
+        uint64_t numberOfNodes = serializeCheckpoint(buffer);
+        if (writeCheckpointFile(buffer) && programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "Checkpoint: " << numberOfNodes << " nodes (" << buffer.size() << " bytes) written to '" << programVariables.checkpointPath << "'" << std::endl;
+        }
+    }
+    SearchStatistics statistics = collectStatistics();
+    programVariables.nodesExpanded = statistics.nodesExpanded;
+    programVariables.provenLowerBound = statistics.lowerBound;
+    programVariables.searchMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    programVariables.solveMilliseconds = std::chrono::duration<double, std::milli>(end - programVariables.solveStartTime).count();
+    if (programVariables.logLevel == LOG_TRACE)
+    {
+        programVariables.traceLog.stop();
+    }
+}
+
+/*
+    Prints the outcome of the search: the totals (at summary level and above), the proven lower bound if a limit stopped the search, the cost of the best route, its configurationMatrix (summary 
+    level and above) and the route itself.
+*/
+void TravelingSalesmanSolver::printSearchResults()
+{
+    if (programVariables.logLevel >= LOG_SUMMARY && programVariables.engineUsed == HELD_KARP_ENGINE)
+    {
+        std::cout << "Held-Karp states: " << programVariables.nodesExpanded.load() << ", wall time: " << programVariables.searchMilliseconds << " ms" << std::endl << std::endl;
+    }
+    else if (programVariables.engineUsed == LIN_KERNIGHAN_ENGINE)
+    {
+        long long bestRouteCost = (long long)programVariables.bestRouteCost.load(); // Large instances have costs beyond the default precision of a double
+        if (programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "Lin-Kernighan restarts completed: " << programVariables.restartsCompleted << ", improving moves: " << programVariables.nodesExpanded.load() 
+                << ", wall time: " << programVariables.searchMilliseconds << " ms" << std::endl;
+            std::cout << "Route cost over time:" << std::endl;
+            for (size_t i = 0; i < programVariables.routeHistory.size(); i++)
+            {
+                std::cout << "  " << std::setw(10) << programVariables.routeHistory[i].first << " ms  " << std::setw(12) << (long long)programVariables.routeHistory[i].second 
+                    << "  +" << (programVariables.routeHistory[i].second - bestRouteCost) / bestRouteCost * 100 << "% over the final route" << std::endl;
+            }
+            std::cout << std::endl;
+        }
+        if (programVariables.stoppedByLimit)
+        {
+            std::cout << "The time limit stopped the Lin-Kernighan engine after " << programVariables.solveMilliseconds << " ms." << std::endl << std::endl;
+        }
+        std::cout << "Best route obtained: " << bestRouteCost << " (heuristic, not proven optimal)" << std::endl << std::endl;
+        printBestRoute();
+        return;
+    }
+    else if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        SearchStatistics statistics = collectStatistics();
+        std::cout << "Nodes expanded: " << programVariables.nodesExpanded.load() << " (" << (programVariables.boundType == ONE_TREE_BOUND ? "1-tree" : "simple") 
+            << " bound, " << BRANCHING_STRATEGY_NAMES[programVariables.branchingStrategy] << " branching" 
+            << (expansionModeUsed() == ROW_EXPANSION ? ", row expansion" : "") 
+            << "), wall time: " << programVariables.searchMilliseconds << " ms" << std::endl;
+        std::cout << "Nodes created: " << statistics.nodesCreated << ", pruned: " << statistics.prunedAtPush << " at push, " << statistics.prunedAtPop 
+            << " at pop, " << statistics.prunedByCompaction << " in " << statistics.queueCompactions << " queue compaction(s), best route updates: " 
+            << statistics.incumbentUpdates << std::endl;
+        if (programVariables.dominanceCache.enabled())
+        {
+            std::cout << "Dominance cache (" << (programVariables.dominanceCacheBytes >> 20) << " MB): " << statistics.dominanceHits << " node(s) dropped, " 
+                << statistics.dominanceMisses << " recorded, " << statistics.dominanceEvictions << " eviction(s)" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    if (programVariables.stoppedByLimit)
+    {
+        double bestRouteCost = programVariables.bestRouteCost.load();
+        std::cout << "The search was stopped by its limit after " << programVariables.solveMilliseconds << " ms. No route costs less than " 
+            << programVariables.provenLowerBound;
+        if (bestRouteCost != std::numeric_limits<double>::infinity() && bestRouteCost > 0)
+        {
+            std::cout << " (gap " << (bestRouteCost - programVariables.provenLowerBound) / bestRouteCost * 100 << "%); the route below is the best one found, not a proven optimum";
+        }
+        std::cout << "." << std::endl << std::endl;
+    }
+
+    if (programVariables.bestRouteCost.load() == std::numeric_limits<double>::infinity())
+    {
+        std::cout << "No route was found." << std::endl;
+        return;
+    }
+
+    std::cout << "Best route obtained: " << programVariables.foundRoute.lowerBound << std::endl << std::endl;
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        print(programVariables.foundRoute); 
+    }
+    printBestRoute();
+}
+
+/*
+    Writes the statistics of the last solve to a JSON file: the instance and settings, the result, the totals, the time spent in each phase
+    (zero unless timeSearchPhases was on) and the counters of each worker. Costs that do not exist (no route was found) are written as null.
+    Returns false (after printing the reason) if the file cannot be written.
+*/
+bool TravelingSalesmanSolver::writeStatisticsReport(const std::string &path)
+{
+    std::ofstream report(path.c_str());
+    if (!report)
+    {
+        std::cerr << "Could not open '" << path << "' for the statistics report." << std::endl;
+        return false;
+    }
+
+    SearchStatistics statistics = collectStatistics();
+    const char *const searchNames[] = { "bestfirst", "dfs", "hybrid" };
+    std::string instance = programVariables.instancePath;
+    if (instance.empty())
+    {
+        instance = "simulation " + std::to_string(programVariables.numberOfCitiesToVisit);
+    }
+    std::string escapedInstance;
+    for (size_t i = 0; i < instance.size(); i++)
+    {
+        if (instance[i] == '"' || instance[i] == '\\')
+        {
+            escapedInstance += '\\';
+        }
+        escapedInstance += instance[i];
+    }
+    auto number = [](double value) { return value == std::numeric_limits<double>::infinity() ? std::string("null") : std::to_string(value); };
+    auto milliseconds = [](long long nanoseconds) { return std::to_string(nanoseconds / 1e6); };
+
+    report << "{\n"
+        << "  \"instance\": \"" << escapedInstance << "\",\n"
+        << "  \"cities\": " << programVariables.numberOfCitiesToVisit << ",\n"
+        << "  \"engine\": \"" << ENGINE_NAMES[programVariables.engineUsed] << "\",\n"
+        << "  \"bound\": \"" << (programVariables.boundType == ONE_TREE_BOUND ? "onetree" : "simple") << "\",\n"
+        << "  \"search\": \"" << searchNames[programVariables.searchMode] << "\",\n"
+        << "  \"expansion\": \"" << EXPANSION_MODE_NAMES[expansionModeUsed()] << "\",\n"
+        << "  \"branching\": \"" << BRANCHING_STRATEGY_NAMES[programVariables.branchingStrategy] << "\",\n"
+        << "  \"threads\": " << programVariables.numberOfThreads << ",\n"
+        << "  \"stopped_by_limit\": " << (programVariables.stoppedByLimit ? "true" : "false") << ",\n"
+        << "  \"route_cost\": " << number(statistics.bestRouteCost) << ",\n"
+        << "  \"lower_bound\": " << number(statistics.lowerBound) << ",\n"
+        << "  \"gap\": " << number(statistics.gap) << ",\n"
+        << "  \"solve_ms\": " << programVariables.solveMilliseconds << ",\n"
+        << "  \"search_ms\": " << programVariables.searchMilliseconds << ",\n"
+        << "  \"first_route_ms\": " << programVariables.firstRouteMilliseconds << ",\n"
+        << "  \"best_route_ms\": " << programVariables.bestRouteMilliseconds << ",\n"
+        << "  \"nodes_created\": " << statistics.nodesCreated << ",\n"
+        << "  \"nodes_expanded\": " << programVariables.nodesExpanded.load() << ",\n"
+        << "  \"pruned_at_push\": " << statistics.prunedAtPush << ",\n"
+        << "  \"pruned_at_pop\": " << statistics.prunedAtPop << ",\n"
+        << "  \"pruned_by_compaction\": " << statistics.prunedByCompaction << ",\n"
+        << "  \"queue_compactions\": " << statistics.queueCompactions << ",\n"
+        << "  \"dominance_hits\": " << statistics.dominanceHits << ",\n"
+        << "  \"dominance_misses\": " << statistics.dominanceMisses << ",\n"
+        << "  \"dominance_evictions\": " << statistics.dominanceEvictions << ",\n"
+        << "  \"peak_queued_nodes\": " << statistics.peakQueuedNodes << ",\n"
+        << "  \"incumbent_updates\": " << statistics.incumbentUpdates << ",\n"
+        << "  \"bound_ms\": " << milliseconds(statistics.boundNanoseconds) << ",\n"
+        << "  \"cycle_check_ms\": " << milliseconds(statistics.cycleCheckNanoseconds) << ",\n"
+        << "  \"queue_ms\": " << milliseconds(statistics.queueNanoseconds) << ",\n"
+        << "  \"restarts_completed\": " << programVariables.restartsCompleted << ",\n"
+        << "  \"route_history\": [";
+    for (size_t i = 0; i < programVariables.routeHistory.size(); i++)
+    {
+        report << (i == 0 ? "" : ", ") << "{ \"ms\": " << number(programVariables.routeHistory[i].first) << ", \"cost\": " << number(programVariables.routeHistory[i].second) << " }";
+    }
+    report << "],\n"
+        << "  \"workers\": [";
+    for (size_t i = 0; i < programVariables.searchCounters.size(); i++)
+    {
+        const SearchCounters &counters = *programVariables.searchCounters[i];
+        report << (i == 0 ? "\n" : ",\n") << "    { \"id\": " << i 
+            << ", \"nodes_created\": " << counters.nodesCreated.load() 
+            << ", \"nodes_expanded\": " << counters.nodesExpanded.load()
+            << ", \"pruned_at_push\": " << counters.prunedAtPush.load() 
+            << ", \"pruned_at_pop\": " << counters.prunedAtPop.load()
+            << ", \"pruned_by_compaction\": " << counters.prunedByCompaction.load()
+            << ", \"queue_compactions\": " << counters.queueCompactions.load()
+            << ", \"dominance_hits\": " << counters.dominanceHits.load()
+            << ", \"dominance_misses\": " << counters.dominanceMisses.load()
+            << ", \"dominance_evictions\": " << counters.dominanceEvictions.load()
+            << ", \"incumbent_updates\": " << counters.incumbentUpdates.load() 
+            << ", \"bound_ms\": " << milliseconds(counters.boundNanoseconds.load())
+            << ", \"cycle_check_ms\": " << milliseconds(counters.cycleCheckNanoseconds.load()) 
+            << ", \"queue_ms\": " << milliseconds(counters.queueNanoseconds.load()) << " }";
+    }
+    report << "\n  ]\n}\n";
+    return bool(report);
+}
+
+/*
+    The program loop for a single worker thread. The worker keeps expanding nodes until every queue is empty and no other worker is 
+    still expanding a node (which could push more work). Between two nodes it pauses if a checkpoint is being taken.
+*/
+void TravelingSalesmanSolver::workerLoop(int id)
+{
+    node poppedNode;
+
+    while (!searchLimitReached(id))
+    {
+        if (programVariables.checkpointRequested.load(std::memory_order_relaxed))
+        {
+            pauseForCheckpoint();
+            continue;
+        }
+        if (!acquireUnprocessedNode(id, poppedNode))
+        {
+            if (programVariables.outstandingNodes.load() == 0) // Nothing queued anywhere and nothing in expansion; the search is complete
+            {
+                programVariables.endProgram = true;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+
+        SearchCounters &counters = *programVariables.searchCounters[id];
+        counters.expandingBound.store(poppedNode.lowerBound, std::memory_order_relaxed);
+        expandNode(poppedNode, id);
+        counters.expandingBound.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        programVariables.outstandingNodes--; // Decremented only after the children have been pushed, so the count never reaches 0 early
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(programVariables.checkpointMutex);
+        programVariables.runningWorkers--; // A checkpoint being taken no longer waits for this worker
+    }
+    programVariables.checkpointCondition.notify_all();
+}
+
+/*
+    Returns true once the search is over: every node has been searched, or a limit was reached. The time limit (measured from the start of 
+    solveLoadedInstance()) and the node limit are only checked every LIMIT_CHECK_INTERVAL calls per worker, since reading the clock and every 
+    worker's counters costs more than expanding a node; a limit can be overshot by that many nodes per worker. Once a limit is reached, 
+    endProgram is set and every worker stops after the node it is on; a depth-first search puts what is left of its subtree back into the 
+    queue first (see spillDepthFirstStack()). The nodes left in the queues keep their bounds, so the proven lower bound can still be read 
+    from them, and a final checkpoint can save them.
+*/
+bool TravelingSalesmanSolver::searchLimitReached(int id)
+{
+    if (programVariables.endProgram)
+    {
+        return true;
+    }
+    if (programVariables.timeLimitSeconds <= 0 && programVariables.nodeLimit <= 0)
+    {
+        return false;
+    }
+    SearchCounters &counters = *programVariables.searchCounters[id];
+    if (++counters.callsSinceLimitCheck < LIMIT_CHECK_INTERVAL)
+    {
+        return false;
+    }
+    counters.callsSinceLimitCheck = 0;
+
+    bool reached = programVariables.timeLimitSeconds > 0 
+        && std::chrono::duration<double>(std::chrono::steady_clock::now() - programVariables.solveStartTime).count() >= programVariables.timeLimitSeconds;
+    if (!reached && programVariables.nodeLimit > 0)
+    {
+        long long expanded = 0;
+        for (size_t i = 0; i < programVariables.searchCounters.size(); i++)
+        {
+            expanded += programVariables.searchCounters[i]->nodesExpanded.load(std::memory_order_relaxed);
+        }
+        reached = expanded >= programVariables.nodeLimit;
+    }
+    if (reached)
+    {
+        programVariables.stoppedByLimit = true;
+        programVariables.endProgram = true;
+    }
+    return reached;
+}
+
+/*
+    Prints a progress line every progressSeconds until the search is over. Runs on a thread of its own next to the workers.
+*/
+void TravelingSalesmanSolver::progressLoop()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> interval(programVariables.progressSeconds);
+    std::unique_lock<std::mutex> lock(programVariables.progressMutex);
+
+    while (!programVariables.progressCondition.wait_for(lock, interval, [this] { return programVariables.endProgram.load(); }))
+    {
+        printProgressLine(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+/*
+    One progress line: nodes expanded (and the rate since the start of the search), queued nodes, pruned nodes, the best route with the 
+    number of times it improved, the smallest bound still open and the gap between the two.
+*/
+void TravelingSalesmanSolver::printProgressLine(double seconds)
+{
+    SearchStatistics statistics = collectStatistics();
+    std::ostringstream line;
+
+    line << std::fixed << std::setprecision(1) << "[" << std::setw(7) << seconds << " s] expanded " << statistics.nodesExpanded 
+        << " (" << std::setprecision(0) << statistics.nodesExpanded / seconds << "/s), queued " << statistics.queuedNodes << " (peak " << statistics.peakQueuedNodes 
+        << "), pruned " << statistics.prunedAtPush << " at push / " << statistics.prunedAtPop << " at pop / " << statistics.prunedByCompaction 
+        << " by compaction, best route ";
+    if (statistics.bestRouteCost == std::numeric_limits<double>::infinity())
+    {
+        line << "none";
+    }
+    else
+    {
+        line << statistics.bestRouteCost << " (" << statistics.incumbentUpdates << " updates), bound " << std::setprecision(1) << statistics.lowerBound 
+            << ", gap " << std::setprecision(2) << statistics.gap * 100 << "%";
+    }
+    std::cout << line.str() << std::endl;
+}
+
+/*
+    Adds up the counters of every worker. While the search runs, the smallest open bound is taken from the top of each queue and the node 
+    each worker is expanding, one after the other; a node moving between the two at that moment can be missed, so the bound (and the gap) 
+    of a running search is an estimate. Once the search is over it is exact.
+*/
+SearchStatistics TravelingSalesmanSolver::collectStatistics()
+{
+    SearchStatistics statistics = SearchStatistics();
+    double lowerBound = std::numeric_limits<double>::infinity();
+
+    for (size_t i = 0; i < programVariables.searchCounters.size(); i++)
+    {
+        const SearchCounters &counters = *programVariables.searchCounters[i];
+        statistics.nodesCreated += counters.nodesCreated.load(std::memory_order_relaxed);
+        statistics.nodesExpanded += counters.nodesExpanded.load(std::memory_order_relaxed);
+        statistics.prunedAtPush += counters.prunedAtPush.load(std::memory_order_relaxed);
+        statistics.prunedAtPop += counters.prunedAtPop.load(std::memory_order_relaxed);
+        statistics.prunedByCompaction += counters.prunedByCompaction.load(std::memory_order_relaxed);
+        statistics.queueCompactions += counters.queueCompactions.load(std::memory_order_relaxed);
+        statistics.dominanceHits += counters.dominanceHits.load(std::memory_order_relaxed);
+        statistics.dominanceMisses += counters.dominanceMisses.load(std::memory_order_relaxed);
+        statistics.dominanceEvictions += counters.dominanceEvictions.load(std::memory_order_relaxed);
+        statistics.incumbentUpdates += counters.incumbentUpdates.load(std::memory_order_relaxed);
+        statistics.boundNanoseconds += counters.boundNanoseconds.load(std::memory_order_relaxed);
+        statistics.cycleCheckNanoseconds += counters.cycleCheckNanoseconds.load(std::memory_order_relaxed);
+        statistics.queueNanoseconds += counters.queueNanoseconds.load(std::memory_order_relaxed);
+        lowerBound = std::min(lowerBound, counters.expandingBound.load(std::memory_order_relaxed));
+    }
+    for (size_t i = 0; i < programVariables.workerQueues.size(); i++)
+    {
+        WorkerQueue &workerQueue = *programVariables.workerQueues[i];
+        std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+        if (!workerQueue.unprocessedNodesQueue.empty())
+        {
+            lowerBound = std::min(lowerBound, workerQueue.unprocessedNodesQueue.top().lowerBound);
+        }
+    }
+
+    statistics.queuedNodes = programVariables.outstandingNodes.load();
+    statistics.peakQueuedNodes = programVariables.peakOutstandingNodes.load();
+    statistics.bestRouteCost = programVariables.bestRouteCost.load();
+    statistics.lowerBound = programVariables.engineUsed == LIN_KERNIGHAN_ENGINE ? std::numeric_limits<double>::infinity() // Nothing is proven
+        : std::min(lowerBound, statistics.bestRouteCost);
+    statistics.gap = statistics.lowerBound == std::numeric_limits<double>::infinity() ? std::numeric_limits<double>::infinity() 
+        : statistics.bestRouteCost > 0 ? (statistics.bestRouteCost - statistics.lowerBound) / statistics.bestRouteCost : 0;
+    return statistics;
+}
+
+/*
+    Takes a checkpoint every checkpointSeconds until the search is over. Runs on a thread of its own next to the workers. The workers are only
+    paused while the queues are copied into memory (see pauseForCheckpoint()); the copy is written to disk after they have resumed, so the 
+    pause does not depend on the speed of the disk.
+*/
+void TravelingSalesmanSolver::checkpointLoop()
+{
+    std::chrono::duration<double> interval(programVariables.checkpointSeconds);
+    std::unique_lock<std::mutex> lock(programVariables.checkpointMutex);
+
+    while (!programVariables.checkpointCondition.wait_for(lock, interval, [this] { return programVariables.endProgram.load(); }))
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        programVariables.checkpointRequested = true;
+        programVariables.checkpointCondition.wait(lock, [this] { return programVariables.pausedWorkers == programVariables.runningWorkers; });
+        std::vector<unsigned char> buffer;
+        uint64_t numberOfNodes = serializeCheckpoint(buffer);
+        programVariables.checkpointRequested = false;
+        lock.unlock();
+        programVariables.checkpointCondition.notify_all();
+
+        double pauseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (writeCheckpointFile(buffer) && programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "Checkpoint: " << numberOfNodes << " nodes (" << buffer.size() << " bytes) written to '" << programVariables.checkpointPath 
+                << "', workers paused " << pauseMilliseconds << " ms" << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+/*
+    Holds a worker between two nodes until the checkpoint thread has copied the queues. The last worker to pause wakes the checkpoint thread.
+*/
+void TravelingSalesmanSolver::pauseForCheckpoint()
+{
+    std::unique_lock<std::mutex> lock(programVariables.checkpointMutex);
+    programVariables.pausedWorkers++;
+    programVariables.checkpointCondition.notify_all();
+    programVariables.checkpointCondition.wait(lock, [this] { return !programVariables.checkpointRequested.load(); });
+    programVariables.pausedWorkers--;
+}
+
+/*
+    Layout of a checkpoint file: a CheckpointHeader, the best route (if one was found) and then every queued node, each as a CheckpointNode 
+    record followed by the node's arena block as it is in memory. Numbers are written in the byte order of the machine, so a checkpoint is 
+    meant to be resumed on the machine (or the kind of machine) that took it. The version changes whenever the layout of the file or of 
+    an arena block does.
+*/
+const char CHECKPOINT_MAGIC[8] = { 'T', 'S', 'P', 'C', 'K', 'P', 'T', '\0' };
+const uint32_t CHECKPOINT_VERSION = 1;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numberOfCities;
+    uint64_t matrixHash; // adjacencyMatrixHash() of the instance; a checkpoint is only resumed on the instance it was taken on
+    uint32_t boundType; // Nodes are only comparable under the bound they were given, and the 1-tree bound adds its penalties to the block
+    uint32_t bytesPerBlock;
+    uint64_t numberOfNodes; // Queued nodes, not counting the best route
+    uint64_t nodesExpanded; // Over every run of the search up to the checkpoint
+    double solveMilliseconds; // Likewise
+    double bestRouteCost; // Infinity if no route was found yet; otherwise the first record is the best route
+};
+
+// One node as stored in a checkpoint or sent to another process of a distributed search (see appendNodeRecord())
+struct CheckpointNode {
+    double lowerBound;
+    uint8_t row; // Constraint
+    uint8_t column;
+    uint8_t includedEdgeCount;
+    uint8_t flags; // Bit 0: include, bit 1: exclude
+    uint32_t reserved; // Keeps the arena block that follows 8-byte aligned
+};
+
+/*
+    Copies the best route and every queued node that can still beat it into buffer, laid out as a checkpoint file. The workers must be 
+    paused or done. Returns the number of queued nodes copied.
+*/
+uint64_t TravelingSalesmanSolver::serializeCheckpoint(std::vector<unsigned char> &buffer)
+{
+    int bytesPerBlock = programVariables.nodeArena.bytesPerBlock();
+    size_t recordBytes = sizeof(CheckpointNode) + bytesPerBlock;
+    double bestRouteCost = programVariables.bestRouteCost.load();
+    CheckpointHeader header = CheckpointHeader();
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.numberOfCities = programVariables.numberOfCitiesToVisit;
+    header.matrixHash = adjacencyMatrixHash();
+    header.boundType = programVariables.boundType;
+    header.bytesPerBlock = bytesPerBlock;
+    header.nodesExpanded = programVariables.nodesExpandedBeforeResume + collectStatistics().nodesExpanded;
+    header.solveMilliseconds = programVariables.millisecondsBeforeResume 
+        + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - programVariables.solveStartTime).count();
+    header.bestRouteCost = bestRouteCost;
+
+    buffer.clear();
+    buffer.reserve(sizeof(header) + (programVariables.outstandingNodes.load() + 1) * recordBytes);
+    buffer.resize(sizeof(header));
+    if (bestRouteCost != std::numeric_limits<double>::infinity())
+    {
+        std::lock_guard<std::mutex> lock(programVariables.routeMutex);
+        appendNodeRecord(buffer, programVariables.foundRoute);
+    }
+    for (size_t i = 0; i < programVariables.workerQueues.size(); i++)
+    {
+        WorkerQueue &workerQueue = *programVariables.workerQueues[i];
+        std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+        const std::vector<node> &nodes = workerQueue.unprocessedNodesQueue.nodes();
+        for (size_t j = 0; j < nodes.size(); j++)
+        {
+            if (nodes[j].lowerBound < bestRouteCost) // The rest would be pruned as soon as they were popped
+            {
+                appendNodeRecord(buffer, nodes[j]);
+                header.numberOfNodes++;
+            }
+        }
+    }
+    std::memcpy(&buffer[0], &header, sizeof(header));
+    return header.numberOfNodes;
+}
+
+/*
+    Appends a node to buffer as a CheckpointNode record followed by a copy of its arena block.
+*/
+void TravelingSalesmanSolver::appendNodeRecord(std::vector<unsigned char> &buffer, const node &nodeX)
+{
+    int bytesPerBlock = programVariables.nodeArena.bytesPerBlock();
+    CheckpointNode record = CheckpointNode();
+    record.lowerBound = nodeX.lowerBound;
+    record.row = nodeX.constraint.first;
+    record.column = nodeX.constraint.second;
+    record.includedEdgeCount = nodeX.includedEdgeCount;
+    record.flags = (nodeX.include ? 1 : 0) | (nodeX.exclude ? 2 : 0);
+    size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(record) + bytesPerBlock);
+    std::memcpy(&buffer[offset], &record, sizeof(record));
+    std::memcpy(&buffer[offset + sizeof(record)], programVariables.nodeArena.block(nodeX.configurationSlot), bytesPerBlock);
+}
+
+/*
+    Turns a record written by appendNodeRecord() back into a node, copying its block into a newly allocated arena block. Returns false,
+    without allocating, if the record's constraint lies outside the matrix.
+*/
+bool TravelingSalesmanSolver::readNodeRecord(const unsigned char *position, node &nodeX, int id)
+{
+    CheckpointNode record;
+    std::memcpy(&record, position, sizeof(record));
+    if (record.row >= programVariables.numberOfCitiesToVisit || record.column >= programVariables.numberOfCitiesToVisit)
+    {
+        return false;
+    }
+
+    nodeX.lowerBound = record.lowerBound;
+    nodeX.constraint = std::make_pair(int(record.row), int(record.column));
+    nodeX.include = (record.flags & 1) != 0;
+    nodeX.exclude = (record.flags & 2) != 0;
+    nodeX.includedEdgeCount = record.includedEdgeCount;
+    nodeX.configurationSlot = programVariables.nodeArena.allocate(id);
+    std::memcpy(programVariables.nodeArena.block(nodeX.configurationSlot), position + sizeof(record), programVariables.nodeArena.bytesPerBlock());
+    return true;
+}
+
+/*
+    Writes a serialized checkpoint next to checkpointPath and then renames it over checkpointPath, so that a run killed while writing leaves 
+    the previous checkpoint intact. Returns false (after printing the reason) if the file cannot be written.
+*/
+bool TravelingSalesmanSolver::writeCheckpointFile(const std::vector<unsigned char> &buffer)
+{
+    std::string temporaryPath = programVariables.checkpointPath + ".tmp";
+    FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    bool written = file != NULL && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && std::fflush(file) == 0;
+#ifndef _WIN32
+    written = written && fsync(fileno(file)) == 0; // On disk before it replaces the previous checkpoint
+#endif
+    if (file != NULL && std::fclose(file) != 0)
+    {
+        written = false;
+    }
+#ifdef _WIN32
+    written = written && MoveFileExA(temporaryPath.c_str(), programVariables.checkpointPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    written = written && std::rename(temporaryPath.c_str(), programVariables.checkpointPath.c_str()) == 0;
+#endif
+
+    if (!written)
+    {
+        std::cerr << "Could not write checkpoint '" << programVariables.checkpointPath << "'." << std::endl;
+        std::remove(temporaryPath.c_str());
+    }
+    return written;
+}
+
+/*
+    Loads a checkpoint written by serializeCheckpoint(): the best route becomes foundRoute and the nodes are dealt out over the worker queues.
+    The file is mapped rather than read, and each block is copied straight from the mapping into the arena. The arena and the queues must be
+    set up. Returns false (after printing the reason) if the file cannot be mapped, is not a checkpoint of this version, was taken on another 
+    instance or with another bound, or is damaged.
+*/
+bool TravelingSalesmanSolver::resumeFromCheckpoint(const std::string &path)
+{
+    MappedFile file(path);
+    if (file.contents == NULL)
+    {
+        std::cerr << "Could not open or map checkpoint '" << path << "'." << std::endl;
+        return false;
+    }
+
+    CheckpointHeader header = CheckpointHeader();
+    if (file.length >= sizeof(header))
+    {
+        std::memcpy(&header, file.contents, sizeof(header));
+    }
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION)
+    {
+        std::cerr << "'" << path << "' is not a version " << CHECKPOINT_VERSION << " checkpoint." << std::endl;
+        return false;
+    }
+    if (header.numberOfCities != uint32_t(programVariables.numberOfCitiesToVisit) || header.matrixHash != adjacencyMatrixHash())
+    {
+        std::cerr << "Checkpoint '" << path << "' was taken on another instance." << std::endl;
+        return false;
+    }
+    if (header.boundType != programVariables.boundType)
+    {
+        std::cerr << "Checkpoint '" << path << "' was taken with the " << (header.boundType == ONE_TREE_BOUND ? "1-tree" : "simple") 
+            << " bound; resume it with the same --bound." << std::endl;
+        return false;
+    }
+    if (header.bytesPerBlock != uint32_t(programVariables.nodeArena.bytesPerBlock()))
+    {
+        std::cerr << "Checkpoint '" << path << "' stores nodes of " << header.bytesPerBlock << " bytes, but this build uses " 
+            << programVariables.nodeArena.bytesPerBlock() << "; it was taken by a different build of the solver." << std::endl;
+        return false;
+    }
+
+    bool hasRoute = header.bestRouteCost != std::numeric_limits<double>::infinity();
+    size_t recordBytes = sizeof(CheckpointNode) + header.bytesPerBlock;
+    uint64_t numberOfRecords = (file.length - sizeof(header)) / recordBytes;
+    if ((file.length - sizeof(header)) % recordBytes != 0 || numberOfRecords != header.numberOfNodes + (hasRoute ? 1 : 0))
+    {
+        std::cerr << "Checkpoint '" << path << "' is cut short or damaged." << std::endl;
+        return false;
+    }
+
+    const unsigned char *position = reinterpret_cast<const unsigned char *>(file.contents) + sizeof(header);
+    for (uint64_t i = 0; i < numberOfRecords; i++, position += recordBytes)
+    {
+        node nodeX;
+        if (!readNodeRecord(position, nodeX, 0))
+        {
+            std::cerr << "Checkpoint '" << path << "' is cut short or damaged." << std::endl;
+            return false;
+        }
+        if (hasRoute && i == 0)
+        {
+            programVariables.foundRoute = nodeX;
+            programVariables.bestRouteCost = nodeX.lowerBound;
+            programVariables.firstRouteMilliseconds = 0;
+            programVariables.bestRouteMilliseconds = 0;
+        }
+        else
+        {
+            pushUnprocessedNode(nodeX, int(i % programVariables.numberOfThreads));
+        }
+    }
+
+    programVariables.nodesExpandedBeforeResume = header.nodesExpanded;
+    programVariables.millisecondsBeforeResume = header.solveMilliseconds;
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Resumed from '" << path << "': " << header.numberOfNodes << " queued nodes, best route ";
+        if (hasRoute)
+        {
+            std::cout << header.bestRouteCost;
+        }
+        else
+        {
+            std::cout << "none";
+        }
+        std::cout << ", " << header.nodesExpanded << " nodes expanded in " << header.solveMilliseconds << " ms before the checkpoint." << std::endl;
+    }
+    return true;
+}
+
+/*
+    FNV-1a hash of the adjacencyMatrix, which identifies the instance a checkpoint was taken on.
+*/
+uint64_t TravelingSalesmanSolver::adjacencyMatrixHash()
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
+    {
+        for (int column = 0; column < programVariables.numberOfCitiesToVisit; column++)
+        {
+            uint32_t cost = programVariables.adjacencyMatrix[row][column];
+            for (int byte = 0; byte < 4; byte++)
+            {
+                hash ^= (cost >> (8 * byte)) & 0xff;
+                hash *= 1099511628211ULL;
+            }
+        }
+    }
+    return hash;
+}
+
+/*
+    Messages of a distributed search (see solveAsCoordinator() and solveAsWorker()). Nodes and routes travel as records written by 
+    appendNodeRecord(), so, like checkpoints, every process must run on the same kind of machine.
+*/
+enum MessageType {
+    MESSAGE_INSTANCE, // Coordinator to worker: an InstanceMessage followed by the adjacencyMatrix, row by row (int32_t)
+    MESSAGE_NODES, // Node records. To a worker: nodes to search. To the coordinator: the answer to MESSAGE_STEAL (possibly none)
+    MESSAGE_ROUTE, // The record of a route better than any the receiver has sent or been sent
+    MESSAGE_IDLE, // Worker to coordinator: every node the worker was given is searched. Payload: its counters so far (see remoteCounters())
+    MESSAGE_STEAL, // Coordinator to worker: give up about half of your queued nodes
+    MESSAGE_DONE // Coordinator to worker: the search is over
+};
+const uint32_t DISTRIBUTED_PROTOCOL_VERSION = 2; // Changes along with the messages or CHECKPOINT_VERSION
+const int REMOTE_COUNTER_COUNT = 13; // Counters a worker process reports with MESSAGE_IDLE, as int64_t
+
+struct InstanceMessage {
+    uint32_t protocolVersion;
+    uint32_t numberOfCities;
+    uint32_t boundType; // The workers give nodes the coordinator's bound, so that bounds from every process compare
+    uint32_t bytesPerBlock;
+};
+
+// The coordinator's view of one worker process
+struct RemoteWorker {
+    std::unique_ptr<MessageSocket> connection;
+    bool idle; // Waiting for nodes
+    bool stealPending; // Sent MESSAGE_STEAL and not answered yet
+    SearchCounters counters; // Totals of the worker process's threads, as last reported
+};
+
+/*
+    The counters of a SearchCounters that travel with MESSAGE_IDLE, in the order they are sent: every count and phase time, so that the 
+    coordinator's totals cover the nodes of every process.
+*/
+std::array<std::atomic<long long> *, REMOTE_COUNTER_COUNT> remoteCounters(SearchCounters &counters)
+{
+    return {{ &counters.nodesCreated, &counters.nodesExpanded, &counters.prunedAtPush, &counters.prunedAtPop, &counters.prunedByCompaction, 
+        &counters.queueCompactions, &counters.incumbentUpdates, &counters.dominanceHits, &counters.dominanceMisses, &counters.dominanceEvictions, 
+        &counters.boundNanoseconds, &counters.cycleCheckNanoseconds, &counters.queueNanoseconds }};
+}
+
+// What the receiving thread of a worker process passes on to its main thread
+struct WorkerInbox {
+    std::mutex inboxMutex;
+    std::condition_variable inboxCondition;
+    std::vector<std::vector<unsigned char> > nodeMessages; // Payloads of MESSAGE_NODES not searched yet
+    bool done; // The coordinator ended the search
+    bool lost; // The connection closed before that
+
+    WorkerInbox() : done(false), lost(false) {}
+};
+
+/*
+    Solves the loaded instance as the coordinator of a distributed search. The root and the starting route are set up as in 
+    solveLoadedInstance(), and the coordinator expands the best nodes itself, best-first on one thread, until it has 
+    DISTRIBUTED_NODES_PER_WORKER open nodes per worker process. It then waits for workerProcesses workers to connect to listenAddress, sends 
+    each one the instance and the best route, and brokers the search (see brokerSubproblems()). The results are left in programVariables as 
+    after solveLoadedInstance(); the searchCounters get one entry per worker process, so the totals cover every process. Returns false 
+    (after printing the reason) if the instance is too small or too large, the address cannot be listened on or a worker is lost.
+*/
+bool TravelingSalesmanSolver::solveAsCoordinator()
+{
+    if (programVariables.numberOfCitiesToVisit < 3 || programVariables.numberOfCitiesToVisit > MAX_CITIES)
+    {
+        std::cerr << "The branch-and-bound engine handles instances of 3 to " << MAX_CITIES << " cities; this one has " 
+            << programVariables.numberOfCitiesToVisit << "." << std::endl;
+        return false;
+    }
+    MessageSocket listener(openSocket(programVariables.listenAddress, true));
+    if (listener.handle == NO_SOCKET)
+    {
+        std::cerr << "Could not listen on '" << programVariables.listenAddress << "'." << std::endl;
+        return false;
+    }
+    if ((programVariables.timeLimitSeconds > 0 || programVariables.nodeLimit > 0 || !programVariables.checkpointPath.empty() || !programVariables.resumePath.empty()) 
+        && programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "The limits and checkpoints do not apply to a distributed search." << std::endl;
+    }
+
+    programVariables.numberOfThreads = 1; // The coordinator only splits the root; the worker processes search
+    programVariables.solveStartTime = std::chrono::steady_clock::now();
+    programVariables.searchCounters.clear();
+    programVariables.searchCounters.push_back(std::unique_ptr<SearchCounters>(new SearchCounters()));
+    if (!programVariables.cityCoordinates.empty())
+    {
+        buildAdjacencyMatrixFromCoordinates();
+    }
+    symmetrizeAdjacencyMatrix();
+    programVariables.engineUsed = BRANCH_AND_BOUND_ENGINE;
+
+    node root = initializeConfigurationMatrix();
+    if (programVariables.warmStart)
+    {
+        seedFoundRouteWithHeuristic();
+    }
+    createWorkerQueues();
+    pushUnprocessedNode(root, 0);
+    SearchMode searchMode = programVariables.searchMode;
+    programVariables.searchMode = BEST_FIRST_SEARCH; // The split must leave its nodes in the queue
+    node poppedNode;
+    while (programVariables.outstandingNodes.load() < programVariables.workerProcesses * DISTRIBUTED_NODES_PER_WORKER && acquireUnprocessedNode(0, poppedNode))
+    {
+        expandNode(poppedNode, 0);
+        programVariables.outstandingNodes--;
+    }
+    programVariables.searchMode = searchMode;
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Split the search into " << programVariables.outstandingNodes.load() << " open nodes; waiting for " << programVariables.workerProcesses 
+            << " worker processes on '" << programVariables.listenAddress << "'." << std::endl;
+    }
+
+    std::vector<unsigned char> instance(sizeof(InstanceMessage) + programVariables.numberOfCitiesToVisit * programVariables.numberOfCitiesToVisit * sizeof(int32_t));
+    InstanceMessage header = { DISTRIBUTED_PROTOCOL_VERSION, uint32_t(programVariables.numberOfCitiesToVisit), uint32_t(programVariables.boundType), 
+        uint32_t(programVariables.nodeArena.bytesPerBlock()) };
+    std::memcpy(&instance[0], &header, sizeof(header));
+    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
+    {
+        std::memcpy(&instance[sizeof(header) + row * programVariables.numberOfCitiesToVisit * sizeof(int32_t)], programVariables.adjacencyMatrix[row], 
+            programVariables.numberOfCitiesToVisit * sizeof(int32_t));
+    }
+    std::vector<unsigned char> route;
+    if (programVariables.bestRouteCost.load() != std::numeric_limits<double>::infinity())
+    {
+        appendNodeRecord(route, programVariables.foundRoute);
+    }
+
+    std::vector<std::unique_ptr<RemoteWorker> > workers;
+    while (workers.size() < size_t(programVariables.workerProcesses))
+    {
+        std::unique_ptr<RemoteWorker> worker(new RemoteWorker());
+        worker->connection.reset(new MessageSocket(acceptSocket(listener.handle)));
+        worker->idle = false;
+        worker->stealPending = false;
+        if (worker->connection->handle == NO_SOCKET || !worker->connection->send(MESSAGE_INSTANCE, instance) 
+            || (!route.empty() && !worker->connection->send(MESSAGE_ROUTE, route)))
+        {
+            std::cerr << "Could not start worker process " << workers.size() << "." << std::endl;
+            return false;
+        }
+        workers.push_back(std::move(worker));
+        if (programVariables.logLevel >= LOG_SUMMARY)
+        {
+            std::cout << "Worker process " << workers.size() - 1 << " connected." << std::endl;
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool completed = brokerSubproblems(workers);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < workers.size() && completed; i++) // Otherwise the workers see their connection close
+    {
+        workers[i]->connection->send(MESSAGE_DONE, std::vector<unsigned char>());
+    }
+    if (programVariables.listenAddress.compare(0, 5, "unix:") == 0)
+    {
+#ifndef _WIN32
+        unlink(programVariables.listenAddress.substr(5).c_str());
+#endif
+    }
+    if (!completed)
+    {
+        return false;
+    }
+
+    programVariables.endProgram = true;
+    for (size_t i = 0; i < workers.size(); i++) // Listed after the coordinator's own counters, one entry per worker process
+    {
+        programVariables.searchCounters.push_back(std::unique_ptr<SearchCounters>(new SearchCounters()));
+        std::array<std::atomic<long long> *, REMOTE_COUNTER_COUNT> reported = remoteCounters(workers[i]->counters);
+        std::array<std::atomic<long long> *, REMOTE_COUNTER_COUNT> total = remoteCounters(*programVariables.searchCounters.back());
+        for (int c = 0; c < REMOTE_COUNTER_COUNT; c++)
+        {
+            total[c]->store(reported[c]->load());
+        }
+    }
+    programVariables.nodesExpanded = collectStatistics().nodesExpanded;
+    programVariables.provenLowerBound = programVariables.bestRouteCost.load();
+    programVariables.searchMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    programVariables.solveMilliseconds = std::chrono::duration<double, std::milli>(end - programVariables.solveStartTime).count();
+    return true;
+}
+
+/*
+    The coordinator's side of a distributed search. The open nodes are kept in the coordinator's queue and handed out to the idle workers
+    (see handOutSubproblems()). Once the queue is empty, busy workers are asked to give up half of their queued nodes, which come back 
+    through the coordinator to the idle ones. A route a worker reports that beats the best one is kept and sent on to every other worker, 
+    so that every process prunes against the best route found anywhere. The search is over when every worker is idle, the queue is 
+    empty and no request for nodes is outstanding. Returns false (after printing the reason) if a worker is lost, since its nodes are lost 
+    with it.
+*/
+bool TravelingSalesmanSolver::brokerSubproblems(std::vector<std::unique_ptr<RemoteWorker> > &workers)
+{
+    std::vector<pollfd> descriptors(workers.size());
+    size_t nextStealTarget = 0;
+    size_t recordBytes = sizeof(CheckpointNode) + programVariables.nodeArena.bytesPerBlock();
+
+    while (true)
+    {
+        if (!handOutSubproblems(workers, nextStealTarget))
+        {
+            return false;
+        }
+        bool finished = programVariables.outstandingNodes.load() == 0;
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            finished = finished && workers[i]->idle && !workers[i]->stealPending;
+            descriptors[i].fd = workers[i]->connection->handle;
+            descriptors[i].events = POLLIN;
+            descriptors[i].revents = 0;
+        }
+        if (finished)
+        {
+            return true;
+        }
+
+        if (pollSockets(descriptors.data(), descriptors.size(), STEAL_RETRY_MILLISECONDS) < 0)
+        {
+            std::cerr << "Could not wait for the worker processes." << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            if (descriptors[i].revents == 0)
+            {
+                continue;
+            }
+            RemoteWorker &worker = *workers[i];
+            uint32_t type = 0;
+            std::vector<unsigned char> payload;
+            bool understood = worker.connection->receive(type, payload);
+            if (understood && type == MESSAGE_IDLE && payload.size() == REMOTE_COUNTER_COUNT * sizeof(int64_t))
+            {
+                std::array<std::atomic<long long> *, REMOTE_COUNTER_COUNT> reported = remoteCounters(worker.counters);
+                for (int c = 0; c < REMOTE_COUNTER_COUNT; c++)
+                {
+                    int64_t value;
+                    std::memcpy(&value, &payload[c * sizeof(int64_t)], sizeof(value));
+                    reported[c]->store(value);
+                }
+                worker.idle = true;
+            }
+            else if (understood && type == MESSAGE_ROUTE && payload.size() == recordBytes)
+            {
+                node route;
+                understood = readNodeRecord(payload.data(), route, 0);
+                if (understood && route.lowerBound < programVariables.bestRouteCost.load())
+                {
+                    for (size_t j = 0; j < workers.size(); j++)
+                    {
+                        if (j != i)
+                        {
+                            workers[j]->connection->send(MESSAGE_ROUTE, payload); // A lost worker is noticed when it is next read
+                        }
+                    }
+                }
+                if (understood)
+                {
+                    updateFoundRoute(route, 0);
+                }
+            }
+            else if (understood && type == MESSAGE_NODES && payload.size() % recordBytes == 0)
+            {
+                worker.stealPending = false;
+                for (size_t offset = 0; offset < payload.size() && understood; offset += recordBytes)
+                {
+                    node nodeX;
+                    understood = readNodeRecord(&payload[offset], nodeX, 0);
+                    if (understood)
+                    {
+                        pushUnprocessedNode(nodeX, 0);
+                    }
+                }
+            }
+            else
+            {
+                understood = false;
+            }
+
+            if (!understood)
+            {
+                std::cerr << "Lost worker process " << i << "; the nodes it held are lost with it, so the search cannot be completed." << std::endl;
+                return false;
+            }
+        }
+    }
+}
+
+/*
+    Shares the coordinator's queue out among the idle workers, the best nodes first and at most a 1/workers share to each. If the queue is empty, a 
+    busy worker is asked for nodes for each idle worker (in turn, starting from nextStealTarget), unless as many requests are already 
+    outstanding. A busy worker whose nodes are all in a depth-first search has none to give, so the requests are repeated every time 
+    brokerSubproblems() wakes up. Returns false (after printing the reason) if a worker cannot be sent to.
+*/
+bool TravelingSalesmanSolver::handOutSubproblems(std::vector<std::unique_ptr<RemoteWorker> > &workers, size_t &nextStealTarget)
+{
+    std::vector<RemoteWorker *> idleWorkers;
+    size_t pendingSteals = 0;
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        if (workers[i]->idle)
+        {
+            idleWorkers.push_back(workers[i].get());
+        }
+        pendingSteals += workers[i]->stealPending ? 1 : 0;
+    }
+    if (idleWorkers.empty())
+    {
+        return true;
+    }
+
+    int queuedNodes = programVariables.outstandingNodes.load();
+    if (queuedNodes > 0)
+    {
+        int share = (queuedNodes + workers.size() - 1) / workers.size(); // A worker that reports in first does not get the busy workers' share
+        for (size_t i = 0; i < idleWorkers.size(); i++)
+        {
+            std::vector<unsigned char> payload;
+            node nodeX;
+            for (int count = 0; count < share && acquireUnprocessedNode(0, nodeX); count++) // Pops the best node, pruning those the best route beats
+            {
+                appendNodeRecord(payload, nodeX);
+                programVariables.nodeArena.release(nodeX.configurationSlot, 0);
+                programVariables.outstandingNodes--;
+            }
+            if (payload.empty())
+            {
+                break;
+            }
+            if (!idleWorkers[i]->connection->send(MESSAGE_NODES, payload))
+            {
+                std::cerr << "Could not send nodes to a worker process." << std::endl;
+                return false;
+            }
+            idleWorkers[i]->idle = false;
+        }
+        return true;
+    }
+
+    for (size_t tried = 0; tried < workers.size() && pendingSteals < idleWorkers.size(); tried++)
+    {
+        RemoteWorker &target = *workers[nextStealTarget];
+        nextStealTarget = (nextStealTarget + 1) % workers.size();
+        if (!target.idle && !target.stealPending)
+        {
+            if (!target.connection->send(MESSAGE_STEAL, std::vector<unsigned char>()))
+            {
+                std::cerr << "Could not ask a worker process for nodes." << std::endl;
+                return false;
+            }
+            target.stealPending = true;
+            pendingSteals++;
+        }
+    }
+    return true;
+}
+
+/*
+    Works for the coordinator of a distributed search at coordinatorAddress, trying to reach it for up to CONNECT_RETRY_SECONDS so that the
+    workers can be started first. The instance and the bound come from the coordinator; the threads and the search order are this process's 
+    own. Every batch of nodes received is searched like a local search (nodeExpansionDispatcher()), after which the worker reports itself 
+    idle. Meanwhile a thread of its own answers the coordinator (see workerReceiveLoop()), and every better route the workers find is sent 
+    to the coordinator from updateFoundRoute(). Returns false (after printing the reason) if the coordinator cannot be reached, or the 
+    connection is lost before the coordinator ends the search.
+*/
+bool TravelingSalesmanSolver::solveAsWorker()
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(CONNECT_RETRY_SECONDS);
+    SocketHandle handle = openSocket(programVariables.coordinatorAddress, false);
+    while (handle == NO_SOCKET && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        handle = openSocket(programVariables.coordinatorAddress, false);
+    }
+    MessageSocket connection(handle);
+    uint32_t type = 0;
+    std::vector<unsigned char> payload;
+    if (handle == NO_SOCKET || !connection.receive(type, payload))
+    {
+        std::cerr << "Could not reach a coordinator at '" << programVariables.coordinatorAddress << "'." << std::endl;
+        return false;
+    }
+
+    InstanceMessage header = InstanceMessage();
+    if (type == MESSAGE_INSTANCE && payload.size() >= sizeof(header))
+    {
+        std::memcpy(&header, payload.data(), sizeof(header));
+    }
+    int numberOfCities = header.numberOfCities;
+    if (header.protocolVersion != DISTRIBUTED_PROTOCOL_VERSION || numberOfCities < 3 || numberOfCities > MAX_CITIES 
+        || payload.size() != sizeof(header) + numberOfCities * numberOfCities * sizeof(int32_t))
+    {
+        std::cerr << "The coordinator at '" << programVariables.coordinatorAddress << "' does not speak version " << DISTRIBUTED_PROTOCOL_VERSION 
+            << " of the protocol." << std::endl;
+        return false;
+    }
+    if ((programVariables.timeLimitSeconds > 0 || programVariables.nodeLimit > 0 || !programVariables.checkpointPath.empty()) && programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "The limits and checkpoints do not apply to a distributed search." << std::endl;
+    }
+    programVariables.timeLimitSeconds = 0; // A worker stopped early would report nodes it never searched as searched
+    programVariables.nodeLimit = 0;
+    programVariables.checkpointPath.clear();
+
+    programVariables.numberOfCitiesToVisit = numberOfCities;
+    programVariables.boundType = header.boundType == ONE_TREE_BOUND ? ONE_TREE_BOUND : SIMPLE_BOUND;
+    programVariables.adjacencyMatrix.assign(numberOfCities);
+    for (int row = 0; row < numberOfCities; row++)
+    {
+        std::memcpy(programVariables.adjacencyMatrix[row], &payload[sizeof(header) + row * numberOfCities * sizeof(int32_t)], numberOfCities * sizeof(int32_t));
+    }
+    programVariables.engineUsed = BRANCH_AND_BOUND_ENGINE;
+    programVariables.solveStartTime = std::chrono::steady_clock::now();
+    programVariables.searchCounters.clear();
+    for (int i = 0; i < programVariables.numberOfThreads; i++)
+    {
+        programVariables.searchCounters.push_back(std::unique_ptr<SearchCounters>(new SearchCounters()));
+    }
+    sizeNodeArena();
+    if (uint32_t(programVariables.nodeArena.bytesPerBlock()) != header.bytesPerBlock)
+    {
+        std::cerr << "The coordinator at '" << programVariables.coordinatorAddress << "' lays out its nodes differently." << std::endl;
+        return false;
+    }
+    createWorkerQueues();
+    programVariables.dominanceCache.reset(programVariables.dominanceCacheBytes);
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Connected to '" << programVariables.coordinatorAddress << "': " << numberOfCities << " cities, " 
+            << (programVariables.boundType == ONE_TREE_BOUND ? "1-tree" : "simple") << " bound." << std::endl;
+    }
+
+    WorkerInbox inbox;
+    programVariables.coordinatorConnection = &connection;
+    std::thread receiver(&TravelingSalesmanSolver::workerReceiveLoop, this, &connection, &inbox);
+    size_t recordBytes = sizeof(CheckpointNode) + programVariables.nodeArena.bytesPerBlock();
+    bool connected = true;
+    while (connected)
+    {
+        std::vector<unsigned char> idle(REMOTE_COUNTER_COUNT * sizeof(int64_t));
+        for (int c = 0; c < REMOTE_COUNTER_COUNT; c++)
+        {
+            int64_t total = 0;
+            for (size_t t = 0; t < programVariables.searchCounters.size(); t++)
+            {
+                total += remoteCounters(*programVariables.searchCounters[t])[c]->load(std::memory_order_relaxed);
+            }
+            std::memcpy(&idle[c * sizeof(int64_t)], &total, sizeof(total));
+        }
+        connected = connection.send(MESSAGE_IDLE, idle);
+
+        std::vector<std::vector<unsigned char> > nodeMessages;
+        {
+            std::unique_lock<std::mutex> lock(inbox.inboxMutex);
+            inbox.inboxCondition.wait(lock, [&inbox] { return !inbox.nodeMessages.empty() || inbox.done || inbox.lost; });
+            nodeMessages.swap(inbox.nodeMessages);
+            connected = connected && !inbox.done && !inbox.lost;
+        }
+
+        int received = 0;
+        for (size_t i = 0; i < nodeMessages.size() && connected; i++)
+        {
+            for (size_t offset = 0; offset + recordBytes <= nodeMessages[i].size(); offset += recordBytes)
+            {
+                node nodeX;
+                if (readNodeRecord(&nodeMessages[i][offset], nodeX, 0))
+                {
+                    pushUnprocessedNode(nodeX, received++ % programVariables.numberOfThreads);
+                }
+            }
+        }
+        if (connected && received > 0)
+        {
+            programVariables.endProgram = false;
+            nodeExpansionDispatcher();
+        }
+    }
+
+    receiver.join();
+    programVariables.coordinatorConnection = NULL;
+    if (!inbox.done)
+    {
+        std::cerr << "Lost the connection to the coordinator at '" << programVariables.coordinatorAddress << "'." << std::endl;
+        return false;
+    }
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "The coordinator ended the search; this process expanded " << collectStatistics().nodesExpanded << " nodes." << std::endl;
+    }
+    return true;
+}
+
+/*
+    The receiving thread of a worker process. Nodes to search are passed on to the main thread through the inbox; routes found by other 
+    processes are taken as the best route if they are better, and requests for nodes are answered straight away (see giveUpQueuedNodes()),
+    while the workers search. The arena blocks this thread allocates and releases go through the cache of id numberOfThreads, which no
+    worker uses.
+*/
+void TravelingSalesmanSolver::workerReceiveLoop(MessageSocket *connection, WorkerInbox *inbox)
+{
+    int id = programVariables.numberOfThreads;
+    size_t recordBytes = sizeof(CheckpointNode) + programVariables.nodeArena.bytesPerBlock();
+    uint32_t type = 0;
+    std::vector<unsigned char> payload;
+    bool done = false;
+
+    while (!done && connection->receive(type, payload))
+    {
+        done = type == MESSAGE_DONE;
+        if (type == MESSAGE_NODES)
+        {
+            std::lock_guard<std::mutex> lock(inbox->inboxMutex);
+            inbox->nodeMessages.push_back(payload);
+            inbox->inboxCondition.notify_all();
+        }
+        else if (type == MESSAGE_ROUTE && payload.size() == recordBytes)
+        {
+            node route;
+            if (readNodeRecord(payload.data(), route, id))
+            {
+                recordRemoteRoute(route, id);
+            }
+        }
+        else if (type == MESSAGE_STEAL && !connection->send(MESSAGE_NODES, giveUpQueuedNodes(id)))
+        {
+            break;
+        }
+    }
+
+    if (!done)
+    {
+        programVariables.endProgram = true; // Nothing this process finds from now on can be reported
+    }
+    std::lock_guard<std::mutex> lock(inbox->inboxMutex);
+    inbox->done = done;
+    inbox->lost = !done;
+    inbox->inboxCondition.notify_all();
+}
+
+/*
+    Takes about half of the nodes of every worker queue, the best ones first and at most MAX_STOLEN_NODES in all, and returns them as node 
+    records for the coordinator to hand to an idle worker. Nodes the best route already beats are dropped instead.
+*/
+std::vector<unsigned char> TravelingSalesmanSolver::giveUpQueuedNodes(int id)
+{
+    std::vector<unsigned char> payload;
+    int given = 0;
+
+    for (size_t i = 0; i < programVariables.workerQueues.size() && given < MAX_STOLEN_NODES; i++)
+    {
+        WorkerQueue &workerQueue = *programVariables.workerQueues[i];
+        std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+        int share = std::min<int>((workerQueue.unprocessedNodesQueue.size() + 1) / 2, MAX_STOLEN_NODES - given);
+        for (int j = 0; j < share; j++)
+        {
+            const node &nodeX = workerQueue.unprocessedNodesQueue.top();
+            if (nodeX.lowerBound < programVariables.bestRouteCost.load())
+            {
+                appendNodeRecord(payload, nodeX);
+                given++;
+            }
+            programVariables.nodeArena.release(nodeX.configurationSlot, id);
+            workerQueue.unprocessedNodesQueue.pop();
+            programVariables.outstandingNodes--;
+        }
+    }
+    return payload;
+}
+
+/*
+    Takes a route found by another process of a distributed search as the best route if it beats it. This is updateFoundRoute() without 
+    the report to the coordinator, which already knows the route.
+*/
+void TravelingSalesmanSolver::recordRemoteRoute(node &nodeX, int id)
+{
+    std::lock_guard<std::mutex> lock(programVariables.routeMutex);
+
+    if (nodeX.lowerBound < programVariables.bestRouteCost.load())
+    {
+        if (programVariables.bestRouteCost.load() != std::numeric_limits<double>::infinity())
+        {
+            programVariables.nodeArena.release(programVariables.foundRoute.configurationSlot, id);
+        }
+        programVariables.foundRoute = nodeX;
+        programVariables.bestRouteCost = nodeX.lowerBound;
+    }
+    else
+    {
+        programVariables.nodeArena.release(nodeX.configurationSlot, id);
+    }
+}
+
+/*
+    Pops the node with the lowest lowerbound from the worker's own queue. If the worker's queue is empty, the other queues are visited 
+    in turn and the best node of the first non-empty one is stolen. Returns false if no node could be found.
+*/
+bool TravelingSalesmanSolver::acquireUnprocessedNode(int id, node &nodeX)
+{
+    PhaseTimer timer(programVariables.timeSearchPhases, programVariables.searchCounters[id]->queueNanoseconds);
+    int numberOfQueues = programVariables.workerQueues.size();
+
+    for (int i = 0; i < numberOfQueues; i++)
+    {
+        WorkerQueue &workerQueue = *programVariables.workerQueues[(id + i) % numberOfQueues];
+        std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+
+        pruneNodesUpdated(workerQueue, id);
+        if (!workerQueue.unprocessedNodesQueue.empty())
+        {
+            nodeX = workerQueue.unprocessedNodesQueue.top();
+            workerQueue.unprocessedNodesQueue.pop();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+    Pushes a node into the worker's own queue.
+*/
+void TravelingSalesmanSolver::pushUnprocessedNode(node &nodeX, int id)
+{
+    PhaseTimer timer(programVariables.timeSearchPhases, programVariables.searchCounters[id]->queueNanoseconds);
+    WorkerQueue &workerQueue = *programVariables.workerQueues[id];
+    int outstandingNodes = ++programVariables.outstandingNodes;
+    int peak = programVariables.peakOutstandingNodes.load(std::memory_order_relaxed);
+    while (outstandingNodes > peak && !programVariables.peakOutstandingNodes.compare_exchange_weak(peak, outstandingNodes, std::memory_order_relaxed))
+    {
+        // A failed exchange reloads peak; another worker may have raised it past outstandingNodes in the meantime
+    }
+
+    std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+    workerQueue.unprocessedNodesQueue.push(nodeX);
+}
+
+/*
+    Pushes a batch of nodes into the worker's own queue, under one lock.
+*/
+void TravelingSalesmanSolver::pushUnprocessedNodes(node *nodes, int numberOfNodes, int id)
+{
+    if (numberOfNodes == 0)
+    {
+        return;
+    }
+    PhaseTimer timer(programVariables.timeSearchPhases, programVariables.searchCounters[id]->queueNanoseconds);
+    WorkerQueue &workerQueue = *programVariables.workerQueues[id];
+    int outstandingNodes = programVariables.outstandingNodes += numberOfNodes;
+    int peak = programVariables.peakOutstandingNodes.load(std::memory_order_relaxed);
+    while (outstandingNodes > peak && !programVariables.peakOutstandingNodes.compare_exchange_weak(peak, outstandingNodes, std::memory_order_relaxed))
+    {
+        // As in pushUnprocessedNode()
+    }
+
+    std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+    for (int i = 0; i < numberOfNodes; i++)
+    {
+        workerQueue.unprocessedNodesQueue.push(nodes[i]);
+    }
+}
+
+/*
+    Carries out one iteration of the program loop on a popped node: the constraint is advanced, and either the node is recorded as a route,
+    or the include/exclude children are created and pushed (with --expansion row, those of every cell left in the row, see expandRow()). 
+    Once the search mode calls for it, the node's whole subtree is searched depth-first instead (see shouldSearchDepthFirst()).
+*/
+void TravelingSalesmanSolver::expandNode(node &nodeX, int id)
+{
+    if (shouldSearchDepthFirst())
+    {
+        searchDepthFirst(nodeX, id);
+        return;
+    }
+
+    bool routeFound = updateNodeConstraint(nodeX, id); // Initially the constraint for the root node is <0><0>; this updates it to <0><1>. For more details on how the update is carried out, check updateNodeConstraint()
+
+    if (routeFound) 
+    {
+        if (programVariables.logLevel == LOG_TRACE)
+        {
+            programVariables.traceLog.record(id, TRACE_ROUTE_FOUND, nodeX);
+        }
+        updateFoundRoute(nodeX, id);
+        return;
+    }
+
+    addToCounter(programVariables.searchCounters[id]->nodesExpanded, 1);
+    if (expansionModeUsed() == ROW_EXPANSION)
+    {
+        expandRow(nodeX, id);
+        return;
+    }
+    setNodeFlags(nodeX, id); // Sets each of nodeX.include and nodeX.exclude depending on whether or not inclusion/exclusion is possible
+
+    // The exclude child takes over the popped node's arena block; the include child only needs its own copy when both children are created
+    node includeNode = (nodeX.include && nodeX.exclude) ? cloneNode(nodeX, id) : nodeX;
+    checkInclude(includeNode, id);
+    checkExclude(nodeX, id);
+
+    if (!nodeX.include && !nodeX.exclude)
+    {
+        programVariables.nodeArena.release(nodeX.configurationSlot, id);
+    }
+}
+
+/*
+    Replaces the best route found so far if the given route is cheaper (and reports it at summary level). Workers find routes concurrently, 
+    so the comparison and the replacement happen under routeMutex. bestRouteCost is published last, so other workers can prune against it without locking.
+    Whichever of the two routes is dropped gives its arena block back. In a worker process of a distributed search, a new best route is also
+    sent to the coordinator, once routeMutex is released.
+*/
+void TravelingSalesmanSolver::updateFoundRoute(node &nodeX, int id)
+{
+    std::vector<unsigned char> report;
+    std::unique_lock<std::mutex> lock(programVariables.routeMutex);
+
+    if (nodeX.lowerBound < programVariables.bestRouteCost.load())
+    {
+        if (programVariables.bestRouteCost.load() != std::numeric_limits<double>::infinity())
+        {
+            programVariables.nodeArena.release(programVariables.foundRoute.configurationSlot, id);
+        }
+        programVariables.bestRouteMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - programVariables.solveStartTime).count();
+        if (programVariables.firstRouteMilliseconds < 0)
+        {
+            programVariables.firstRouteMilliseconds = programVariables.bestRouteMilliseconds;
+        }
+        programVariables.foundRoute = nodeX;
+        programVariables.bestRouteCost = nodeX.lowerBound;
+        addToCounter(programVariables.searchCounters[id]->incumbentUpdates, 1);
+        if (programVariables.logLevel >= LOG_SUMMARY) // Reported as it happens, so a run that is stopped early has already shown its best route
+        {
+            std::cout << "Best route so far: " << nodeX.lowerBound << " after " << programVariables.bestRouteMilliseconds << " ms" << std::endl;
+        }
+        if (programVariables.coordinatorConnection != NULL)
+        {
+            appendNodeRecord(report, nodeX);
+        }
+    }
+    else
+    {
+        programVariables.nodeArena.release(nodeX.configurationSlot, id);
+    }
+
+    lock.unlock();
+    if (!report.empty())
+    {
+        programVariables.coordinatorConnection->send(MESSAGE_ROUTE, report); // A lost coordinator is noticed by the receiving thread
+    }
+}
+
+/*
+    Decides whether a popped node is searched depth-first (see searchDepthFirst()) instead of having its children queued:
+        best-first   never
+        dfs          once the queues hold DEPTH_FIRST_SUBTREES_PER_WORKER nodes per worker, so the queues only serve to hand subtrees to the workers
+        hybrid       once the queued nodes (their arena blocks included) take up the memory budget
+    Either way the queues stop growing, so memory stays flat for the rest of the search.
+*/
+bool TravelingSalesmanSolver::shouldSearchDepthFirst()
+{
+    long long queuedNodes = programVariables.outstandingNodes.load(std::memory_order_relaxed);
+
+    if (programVariables.searchMode == DEPTH_FIRST_SEARCH)
+    {
+        return queuedNodes >= (long long)programVariables.numberOfThreads * DEPTH_FIRST_SUBTREES_PER_WORKER;
+    }
+    if (programVariables.searchMode == HYBRID_SEARCH)
+    {
+        return queuedNodes * (long long)(sizeof(node) + programVariables.nodeArena.bytesPerBlock()) >= programVariables.memoryBudget;
+    }
+    return false;
+}
+
+/*
+    Branch-and-bound over the whole subtree below a popped node, depth first. The node is modified in place: a child is made by applying its 
+    edge to the matrix, and after the child's subtree has been searched the edge is taken back out (undoDepthFirstChild()), so the search 
+    needs one arena block however deep it goes. Subtrees are pruned against the best route, which other workers may improve at any time.
+    Routes found are copied into a block of their own before being recorded.
+
+    The levels of the search are kept on the worker's DepthFirstStack rather than the call stack, as a tree can be N(N-1)/2 levels deep.
+    If a limit is reached or a checkpoint is requested, the part of the subtree not yet searched is queued and the search returns.
+*/
+void TravelingSalesmanSolver::searchDepthFirst(node &nodeX, int id)
+{
+    DepthFirstStack &stack = programVariables.depthFirstStacks[id];
+    enterDepthFirstNode(nodeX, stack, id);
+
+    while (!stack.frames.empty())
+    {
+        if (searchLimitReached(id) || programVariables.checkpointRequested.load(std::memory_order_relaxed))
+        {
+            spillDepthFirstStack(nodeX, stack, id); // The workers only stop or pause between queued nodes
+            break;
+        }
+
+        DepthFirstFrame &frame = stack.frames.back();
+        undoDepthFirstChild(nodeX, stack);
+
+        if (frame.nextChild == 0)
+        {
+            frame.nextChild = 1;
+            if (frame.parent.include)
+            {
+                applyDepthFirstChild(nodeX, stack, true, id);
+                enterDepthFirstNode(nodeX, stack, id);
+            }
+            else if (programVariables.logLevel == LOG_TRACE)
+            {
+                programVariables.traceLog.record(id, TRACE_CANNOT_INCLUDE, nodeX);
+            }
+        }
+        else if (frame.nextChild == 1)
+        {
+            frame.nextChild = 2;
+            if (frame.parent.exclude)
+            {
+                applyDepthFirstChild(nodeX, stack, false, id);
+                enterDepthFirstNode(nodeX, stack, id);
+            }
+            else if (programVariables.logLevel == LOG_TRACE)
+            {
+                programVariables.traceLog.record(id, TRACE_CANNOT_EXCLUDE, nodeX);
+            }
+        }
+        else
+        {
+            stack.frames.pop_back();
+            if (programVariables.boundType == ONE_TREE_BOUND)
+            {
+                stack.penalties.resize(stack.penalties.size() - programVariables.numberOfCitiesToVisit);
+            }
+        }
+    }
+
+    programVariables.nodeArena.release(nodeX.configurationSlot, id);
+}
+
+/*
+    The depth-first counterpart of a pop: the node is pruned if its bound cannot beat the best route, recorded if it is a route, and 
+    otherwise given a level on the stack from which its children are made.
+*/
+void TravelingSalesmanSolver::enterDepthFirstNode(node &nodeX, DepthFirstStack &stack, int id)
+{
+    if (nodeX.lowerBound >= programVariables.bestRouteCost.load())
+    {
+        if (programVariables.logLevel == LOG_TRACE)
+        {
+            programVariables.traceLog.record(id, TRACE_PRUNED, nodeX);
+        }
+        addToCounter(programVariables.searchCounters[id]->prunedAtPop, 1);
+        return;
+    }
+    if (dominatedByCheaperNode(nodeX, id))
+    {
+        return;
+    }
+
+    if (updateNodeConstraint(nodeX, id))
+    {
+        if (programVariables.logLevel == LOG_TRACE)
+        {
+            programVariables.traceLog.record(id, TRACE_ROUTE_FOUND, nodeX);
+        }
+        node route = cloneNode(nodeX, id);
+        updateFoundRoute(route, id);
+        return;
+    }
+
+    addToCounter(programVariables.searchCounters[id]->nodesExpanded, 1);
+    setNodeFlags(nodeX, id);
+
+    Configuration configuration = configurationOf(nodeX);
+    DepthFirstFrame frame;
+    frame.parent = nodeX;
+    frame.nextChild = 0;
+    frame.appliedChild = 0;
+    stack.frames.push_back(frame);
+    if (configuration.penalties != NULL)
+    {
+        stack.penalties.insert(stack.penalties.end(), configuration.penalties, configuration.penalties + programVariables.numberOfCitiesToVisit);
+    }
+}
+
+/*
+    Turns the node of the top level into its include or exclude child, the way checkInclude() and checkExclude() do for a queued child.
+*/
+void TravelingSalesmanSolver::applyDepthFirstChild(node &nodeX, DepthFirstStack &stack, bool include, int id)
+{
+    DepthFirstFrame &frame = stack.frames.back();
+    Configuration configuration = configurationOf(nodeX);
+    frame.appliedChild = include ? 1 : 2;
+    frame.change = modifyMatrix(nodeX, include);
+    for (int i = 0; i < frame.change.numberOfRows; i++)
+    {
+        frame.rowLowerBound[i] = configuration.rowLowerBound[frame.change.rows[i]];
+    }
+    frame.lowerBoundTotal = *configuration.lowerBoundTotal;
+    {
+        SearchCounters &counters = *programVariables.searchCounters[id];
+        PhaseTimer timer(programVariables.timeSearchPhases, counters.boundNanoseconds);
+        calculateLowerBoundForNodeUpdated(nodeX, frame.change);
+        if (programVariables.boundType == ONE_TREE_BOUND)
+        {
+            calculateOneTreeBound(nodeX, CHILD_SUBGRADIENT_ITERATIONS, id);
+        }
+        addToCounter(counters.nodesCreated, 1);
+    }
+    if (programVariables.logLevel == LOG_TRACE)
+    {
+        programVariables.traceLog.record(id, include ? TRACE_INCLUDED : TRACE_EXCLUDED, nodeX);
+    }
+}
+
+/*
+    Takes the child edge applied at the top level (if any) back out of the matrix, and restores the node, its bound cache and its penalties 
+    to what they were before the child was made.
+*/
+void TravelingSalesmanSolver::undoDepthFirstChild(node &nodeX, DepthFirstStack &stack)
+{
+    DepthFirstFrame &frame = stack.frames.back();
+    if (frame.appliedChild == 0)
+    {
+        return;
+    }
+
+    nodeX.constraint = frame.parent.constraint; // The child's level advanced the constraint past the cell it changed
+    undoModifyMatrix(nodeX, frame.appliedChild == 1, frame.change);
+    nodeX = frame.parent;
+    frame.appliedChild = 0;
+
+    Configuration configuration = configurationOf(nodeX);
+    for (int i = 0; i < frame.change.numberOfRows; i++)
+    {
+        configuration.rowLowerBound[frame.change.rows[i]] = frame.rowLowerBound[i];
+    }
+    *configuration.lowerBoundTotal = frame.lowerBoundTotal;
+    if (configuration.penalties != NULL)
+    {
+        std::copy(stack.penalties.end() - programVariables.numberOfCitiesToVisit, stack.penalties.end(), configuration.penalties);
+    }
+}
+
+/*
+    Ends a depth-first search early without losing any of it: level by level from the top, the child edge is taken back out and each child 
+    of the level not yet searched is copied into a block of its own and queued, the way expandNode() would have queued it. The children
+    of a level that are already searched are skipped, and so is the child whose subtree was being searched, since the levels above it 
+    have just queued what was left of that subtree.
+*/
+void TravelingSalesmanSolver::spillDepthFirstStack(node &nodeX, DepthFirstStack &stack, int id)
+{
+    while (!stack.frames.empty())
+    {
+        DepthFirstFrame &frame = stack.frames.back();
+        undoDepthFirstChild(nodeX, stack); // nodeX is now the level's node, with its constraint advanced and its flags set
+
+        if (frame.nextChild == 0 && frame.parent.include)
+        {
+            node includeNode = cloneNode(nodeX, id);
+            checkInclude(includeNode, id);
+        }
+        if (frame.nextChild <= 1 && frame.parent.exclude)
+        {
+            node excludeNode = cloneNode(nodeX, id);
+            checkExclude(excludeNode, id);
+        }
+
+        stack.frames.pop_back();
+        if (programVariables.boundType == ONE_TREE_BOUND)
+        {
+            stack.penalties.resize(stack.penalties.size() - programVariables.numberOfCitiesToVisit);
+        }
+    }
+}
+
+/*
+    The constraint for a node is updated column by column until the end of the row is reached. Upon reaching the end of a row, the row is incremented and the column is 
+    set to the row + 1. Using the 5-city simulation as an example, the constraint would start at <0><0> and would be incremented column by column until it reached <0><4>. 
+    The next update would set the constraint to <1><2>, and consecutive updates would go back to column by column until the end of the row was reached again. 
+    Cells that are already decided (an edge excluded by modifyMatrix() because it would have closed a subtour) are skipped.
+
+    This method is also important in that it returns true if a route is found. A route is found when the constraint can no longer be updated, because every cell 
+    after it has been decided. In the 5-city simulation with no skipped cells, this would be at <3><4>, for if we tried to update the constraint, we would have <4><5> 
+    and fall off the matrix. 
+
+    This walk is the row-major branching strategy (the default); the other strategies pick the next edge from anywhere in the matrix, see chooseBranchingEdge().
+*/
+bool TravelingSalesmanSolver::updateNodeConstraint(node &nodeX, int id)
+{
+    if (programVariables.branchingStrategy != ROW_MAJOR_BRANCHING)
+    {
+        return chooseBranchingEdge(nodeX, id);
+    }
+
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    RowMask allCities = numberOfCities == MAX_CITIES ? ~RowMask(0) : (RowMask(1) << numberOfCities) - 1;
+    Configuration configuration = configurationOf(nodeX);
+    int currentRow = nodeX.constraint.first;
+    int currentColumn = nodeX.constraint.second;
+
+    for (int row = currentRow; row < numberOfCities - 1; row++)
+    {
+        int firstColumn = row == currentRow ? currentColumn + 1 : row + 1; // Only the upper triangle is walked; the matrix is symmetrical
+        RowMask laterColumns = firstColumn >= MAX_CITIES ? 0 : allCities & ~((RowMask(1) << firstColumn) - 1);
+        RowMask undecided = laterColumns & ~(configuration.includedEdges[row] | configuration.excludedEdges[row]);
+        if (undecided != 0)
+        {
+            // Set constraint for node to updated values
+            nodeX.constraint.first = row;
+            nodeX.constraint.second = __builtin_ctzll(undecided);
+            return false;
+        }
+    }
+
+    return true; // Constraint cannot be updated further; a route has been found
+}
+
+/*
+    updateNodeConstraint() for the strategies that choose the next edge by its cost or its effect on the bound instead of its position. Any 
+    undecided edge can be picked, so the constraint no longer tells which cells are decided; a route is found once no cell is left undecided.
+
+    An undecided edge of a city that already has its two edges can only be excluded, so it is taken first, whatever the strategy: its node 
+    has a single child, and the bound of the city at the other end tightens. Once no such edge is left, every undecided edge joins two cities 
+    that can still be given one, and the strategy picks among them:
+        constrained  the cheapest edge of the city with the fewest undecided edges (on a tie, one that already has an edge), so that the 
+                     cities closest to being decided are decided first
+        penalty      the edge whose exclusion raises the simple bound the most (see scoreExclusionPenalties()), so that the exclude child
+                     is pruned early, or the include child made certain
+        strong       the STRONG_BRANCHING_CANDIDATES edges with the highest penalties are tried: both children of each are bounded with 
+                     the node's own bound, and the edge whose weaker child has the highest bound is taken (the other child's bound breaks ties)
+*/
+bool TravelingSalesmanSolver::chooseBranchingEdge(node &nodeX, int id)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    RowMask allCities = numberOfCities == MAX_CITIES ? ~RowMask(0) : (RowMask(1) << numberOfCities) - 1;
+    Configuration configuration = configurationOf(nodeX);
+    RowMask undecided[MAX_CITIES];
+    bool anyUndecided = false;
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        undecided[city] = allCities & ~(configuration.includedEdges[city] | configuration.excludedEdges[city] | (RowMask(1) << city));
+        anyUndecided = anyUndecided || undecided[city] != 0;
+        if (undecided[city] != 0 && configuration.includeColumn[city] == 2)
+        {
+            int other = __builtin_ctzll(undecided[city]);
+            nodeX.constraint = std::make_pair(std::min(city, other), std::max(city, other));
+            return false;
+        }
+    }
+    if (!anyUndecided)
+    {
+        return true; // Every cell is decided; a route has been found
+    }
+
+    if (programVariables.branchingStrategy == CONSTRAINED_CITY_BRANCHING)
+    {
+        int chosenCity = -1;
+        int fewestUndecided = MAX_CITIES + 1;
+        for (int city = 0; city < numberOfCities; city++)
+        {
+            int count = __builtin_popcountll(undecided[city]);
+            if (count > 0 && (count < fewestUndecided || (count == fewestUndecided && configuration.includeColumn[city] > configuration.includeColumn[chosenCity])))
+            {
+                chosenCity = city;
+                fewestUndecided = count;
+            }
+        }
+
+        const int *costs = programVariables.adjacencyMatrix[chosenCity];
+        int cheapest = -1;
+        for (RowMask edges = undecided[chosenCity]; edges != 0; edges &= edges - 1)
+        {
+            int other = __builtin_ctzll(edges);
+            cheapest = (cheapest < 0 || costs[other] < costs[cheapest]) ? other : cheapest;
+        }
+        nodeX.constraint = std::make_pair(std::min(chosenCity, cheapest), std::max(chosenCity, cheapest));
+        return false;
+    }
+
+    BranchingCandidate candidates[2 * MAX_CITIES];
+    int numberOfCandidates = scoreExclusionPenalties(configuration, undecided, candidates);
+    auto higherPenalty = [](const BranchingCandidate &a, const BranchingCandidate &b) 
+    { 
+        return a.penalty != b.penalty ? a.penalty > b.penalty : a.cost != b.cost ? a.cost < b.cost : std::make_pair(a.first, a.second) < std::make_pair(b.first, b.second); 
+    };
+
+    if (programVariables.branchingStrategy == EXCLUSION_PENALTY_BRANCHING)
+    {
+        const BranchingCandidate &best = *std::min_element(candidates, candidates + numberOfCandidates, higherPenalty);
+        nodeX.constraint = std::make_pair(best.first, best.second);
+        return false;
+    }
+
+    int numberOfTried = std::min(numberOfCandidates, STRONG_BRANCHING_CANDIDATES);
+    std::partial_sort(candidates, candidates + numberOfTried, candidates + numberOfCandidates, higherPenalty);
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::pair<double, double> bestScore(-infinity, -infinity);
+    std::pair<int, int> bestEdge = std::make_pair(candidates[0].first, candidates[0].second);
+
+    for (int i = 0; i < numberOfTried; i++)
+    {
+        nodeX.constraint = std::make_pair(candidates[i].first, candidates[i].second);
+        setNodeFlags(nodeX, id);
+        double includeBound = nodeX.include ? evaluateBranchingChild(nodeX, true, id) : infinity;
+        double excludeBound = nodeX.exclude ? evaluateBranchingChild(nodeX, false, id) : infinity;
+        std::pair<double, double> score(std::min(includeBound, excludeBound), std::max(includeBound, excludeBound));
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestEdge = nodeX.constraint;
+        }
+        if (bestScore.first >= programVariables.bestRouteCost.load())
+        {
+            break; // Both children of this edge are pruned as soon as they are made
+        }
+    }
+
+    nodeX.constraint = bestEdge;
+    return false;
+}
+
+/*
+    The exclusion penalty of an undecided edge is how much excluding it would raise the simple bound (see calculateRowLowerBound()): a city
+    that still needs k edges uses its k cheapest undecided edges in the bound, and excluding one of them makes it use its (k+1)-th cheapest 
+    instead, or leaves the city unable to get two edges if it has no such edge. Only the edges a city uses in its bound have a penalty at that 
+    city, so the candidates are the edges used by at least one of their cities (every city with an undecided edge uses one), each scored with 
+    the sum of its penalties at both cities. Every city must still be able to take an edge (see chooseBranchingEdge()).
+    
+    The penalties are computed for the simple bound even when the 1-tree bound is selected; they are cheap, and still point at the edges
+    the route most depends on. Returns the number of candidates written.
+*/
+int TravelingSalesmanSolver::scoreExclusionPenalties(const Configuration &configuration, const RowMask *undecided, BranchingCandidate *candidates)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    int usedEdge[MAX_CITIES][2]; // The undecided edges each city uses in its bound, cheapest first; -1 where there is none
+    long long usedPenalty[MAX_CITIES][2];
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        const int *costs = programVariables.adjacencyMatrix[city];
+        int needed = 2 - configuration.includeColumn[city];
+        int cheapest[3] = { -1, -1, -1 };
+        for (RowMask edges = undecided[city]; edges != 0; edges &= edges - 1)
+        {
+            int other = __builtin_ctzll(edges);
+            for (int k = 0; k < 3; k++)
+            {
+                if (cheapest[k] < 0 || costs[other] < costs[cheapest[k]])
+                {
+                    std::swap(other, cheapest[k]); // The displaced edge moves down the list
+                    if (other < 0)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (int k = 0; k < 2; k++)
+        {
+            usedEdge[city][k] = k < needed ? cheapest[k] : -1;
+            usedPenalty[city][k] = cheapest[needed] < 0 ? UNUSABLE_EDGE : costs[cheapest[needed]] - (usedEdge[city][k] < 0 ? 0 : costs[usedEdge[city][k]]);
+        }
+    }
+
+    int numberOfCandidates = 0;
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            int other = usedEdge[city][k];
+            if (other < 0)
+            {
+                continue;
+            }
+            long long penalty = usedPenalty[city][k];
+            bool usedByOther = false;
+            for (int j = 0; j < 2; j++)
+            {
+                if (usedEdge[other][j] == city)
+                {
+                    penalty += usedPenalty[other][j];
+                    usedByOther = true;
+                }
+            }
+            if (usedByOther && other < city)
+            {
+                continue; // Already scored from the other city
+            }
+
+            BranchingCandidate &candidate = candidates[numberOfCandidates++];
+            candidate.first = std::min(city, other);
+            candidate.second = std::max(city, other);
+            candidate.penalty = penalty;
+            candidate.cost = programVariables.adjacencyMatrix[city][other];
+        }
+    }
+
+    return numberOfCandidates;
+}
+
+/*
+    Bounds the include or exclude child of the node's constraint the way checkInclude() and checkExclude() would, then takes the change back 
+    out, leaving the node, its bound cache and its penalties as they were. Returns the child's bound. Used by strong branching, which bounds
+    the children of several edges before branching on one of them.
+*/
+double TravelingSalesmanSolver::evaluateBranchingChild(node &nodeX, bool include, int id)
+{
+    PhaseTimer timer(programVariables.timeSearchPhases, programVariables.searchCounters[id]->boundNanoseconds);
+    Configuration configuration = configurationOf(nodeX);
+    node parent = nodeX;
+    double penalties[MAX_CITIES];
+    if (configuration.penalties != NULL)
+    {
+        std::copy(configuration.penalties, configuration.penalties + programVariables.numberOfCitiesToVisit, penalties);
+    }
+
+    MatrixChange change = modifyMatrix(nodeX, include);
+    int rowLowerBound[4];
+    for (int i = 0; i < change.numberOfRows; i++)
+    {
+        rowLowerBound[i] = configuration.rowLowerBound[change.rows[i]];
+    }
+    int lowerBoundTotal = *configuration.lowerBoundTotal;
+    calculateLowerBoundForNodeUpdated(nodeX, change);
+    if (programVariables.boundType == ONE_TREE_BOUND)
+    {
+        calculateOneTreeBound(nodeX, CHILD_SUBGRADIENT_ITERATIONS, id);
+    }
+    double bound = nodeX.lowerBound;
+
+    undoModifyMatrix(nodeX, include, change);
+    for (int i = 0; i < change.numberOfRows; i++)
+    {
+        configuration.rowLowerBound[change.rows[i]] = rowLowerBound[i];
+    }
+    *configuration.lowerBoundTotal = lowerBoundTotal;
+    if (configuration.penalties != NULL)
+    {
+        std::copy(penalties, penalties + programVariables.numberOfCitiesToVisit, configuration.penalties);
+    }
+    nodeX = parent;
+    return bound;
+}
+
+/*
+    Each node contains boolean variables to indicate whether the current edge given by the constraint can be included or excluded. This method will 
+    set those boolean variables by examining the last two columns of the configurationMatrix, for both cities of the edge. The second to last column 
+    gives the number of edges that have been included for each row, and the last column gives the number of edges that can still be included or 
+    excluded. When the configurationMatrix for the root node is first initialized, the last column is set to numberOfCitiesToVisit - 1. To use the 
+    5-city simulation as an example, the last column will be initialized to 4, meaning 4 edges in each row can be included or excluded. 
+
+    When an edge is included, the include column is incremented, and the exclude column is decremented. When an edge is excluded, only the exclude column is decremented.
+
+    An edge can be included if neither city already has its two edges and it does not close a subtour (see checkForCycles()). It can be excluded 
+    if both cities can still be given two edges afterwards: the edges they already have, plus the undecided ones other than this one.
+*/
+void TravelingSalesmanSolver::setNodeFlags(node &nodeX, int id)
+{
+    int currentRow = nodeX.constraint.first;
+    int currentColumn = nodeX.constraint.second;
+    Configuration configuration = configurationOf(nodeX);
+    const uint8_t *includeColumn = configuration.includeColumn; // # of edges included in a row
+    const uint8_t *excludeColumn = configuration.excludeColumn; // # of edges that can be included/excluded in a row
+
+    nodeX.include = includeColumn[currentRow] < 2 && includeColumn[currentColumn] < 2;
+    if (nodeX.include)
+    {
+        PhaseTimer timer(programVariables.timeSearchPhases, programVariables.searchCounters[id]->cycleCheckNanoseconds);
+        nodeX.include = checkForCycles(nodeX);
+    }
+    nodeX.exclude = includeColumn[currentRow] + excludeColumn[currentRow] - 1 >= 2 && includeColumn[currentColumn] + excludeColumn[currentColumn] - 1 >= 2;
+}
+
+/*
+    Returns true if the constraint's edge can be included without closing a subtour. Both cities of an includable edge are fragment ends, and the
+    edge closes a cycle exactly when it joins the two ends of the same fragment. That is only allowed for the last edge of the route, which 
+    closes the path through every city. modifyMatrix() already excludes such an edge as soon as the fragment forms, so this is a safeguard.
+*/
+bool TravelingSalesmanSolver::checkForCycles(const node &nodeX)
+{
+    Configuration configuration = configurationOf(nodeX);
+    bool closesFragment = configuration.fragmentEnd[nodeX.constraint.first] == nodeX.constraint.second;
+
+    return !closesFragment || nodeX.includedEdgeCount == programVariables.numberOfCitiesToVisit - 1;
+}
+
+/*
+    This method is called after it is determined that the current cell edge (given by the constraint) can be included. In trace mode
+    the decision is recorded in the worker's trace ring rather than printed, so workers never wait on each other to report.
+
+    A child that cannot beat the best route (its lowerBound is at least the route's cost, or infinite because a city can no longer be given two 
+    edges) is dropped instead of queued, so it never takes up queue memory or heap operations.
+*/
+void TravelingSalesmanSolver::checkInclude(node &nodeX, int id)
+{
+    
+    if (nodeX.include)
+    {
+        if (boundChild(nodeX, true, id))
+        {
+            pushUnprocessedNode(nodeX, id); // The node, now having an updated lowerbound and constraint, is pushed back into the worker's queue
+        }
+    }
+    else if (programVariables.logLevel == LOG_TRACE)
+    {   
+        programVariables.traceLog.record(id, TRACE_CANNOT_INCLUDE, nodeX);
+    }
+
+}
+
+/*
+    This method is called after it is determined that the current cell edge (given by the constraint) can be excluded. Like an include child,
+    the child is dropped if it cannot beat the best route.
+*/
+void TravelingSalesmanSolver::checkExclude(node &nodeX, int id)
+{
+    
+    if (nodeX.exclude)
+    {
+        if (boundChild(nodeX, false, id))
+        {
+            pushUnprocessedNode(nodeX, id);
+        }
+    }
+    else if (programVariables.logLevel == LOG_TRACE)
+    {
+        programVariables.traceLog.record(id, TRACE_CANNOT_EXCLUDE, nodeX);
+    }
+}
+
+/*
+    Turns the node into its include or exclude child for the edge given by the constraint and bounds it. Returns true if the child is to be 
+    queued; a child that cannot beat the best route, or that a cheaper node dominates, is dropped instead and its arena block given back.
+*/
+bool TravelingSalesmanSolver::boundChild(node &nodeX, bool include, int id)
+{
+    SearchCounters &counters = *programVariables.searchCounters[id];
+    MatrixChange change = modifyMatrix(nodeX, include); // Adds the edge that will be included/excluded to the appropriate configurationMatrix cell
+    {
+        PhaseTimer timer(programVariables.timeSearchPhases, counters.boundNanoseconds);
+        calculateLowerBoundForNodeUpdated(nodeX, change); // Calculates new lower bound with consideration for the included/excluded edge
+        if (programVariables.boundType == ONE_TREE_BOUND)
+        {
+            calculateOneTreeBound(nodeX, CHILD_SUBGRADIENT_ITERATIONS, id);
+        }
+    }
+    addToCounter(counters.nodesCreated, 1);
+    if (programVariables.logLevel == LOG_TRACE)
+    {
+        programVariables.traceLog.record(id, nodeX.lowerBound >= programVariables.bestRouteCost.load() ? TRACE_PRUNED : include ? TRACE_INCLUDED : TRACE_EXCLUDED, nodeX);
+    }
+
+    if (nodeX.lowerBound >= programVariables.bestRouteCost.load())
+    {
+        programVariables.nodeArena.release(nodeX.configurationSlot, id);
+        addToCounter(counters.prunedAtPush, 1);
+        return false;
+    }
+    if (dominatedByCheaperNode(nodeX, id))
+    {
+        programVariables.nodeArena.release(nodeX.configurationSlot, id);
+        return false;
+    }
+    return true;
+}
+
+/*
+    The expansion the search uses: --expansion row only applies to row-major branching, whose next edge is always the next cell of the row. 
+    Any other strategy expands one edge per pop.
+*/
+ExpansionMode TravelingSalesmanSolver::expansionModeUsed()
+{
+    return programVariables.branchingStrategy == ROW_MAJOR_BRANCHING ? programVariables.expansionMode : EDGE_EXPANSION;
+}
+
+/*
+    Expands a popped node over every undecided cell left in its constraint's row at once (--expansion row), instead of one cell per pop. 
+    The edge-by-edge expansion reaches the same children through a chain of exclude children, each of which is queued and popped again 
+    only to branch on the next cell; here that chain is walked in place. For the k-th undecided cell the include child is made from the 
+    node with the k - 1 cells before it excluded, and the node itself then takes the exclusion of the cell and moves on. What the flags 
+    of setNodeFlags() would say for each cell is worked out for the whole row first, as masks: exclusions never change which cells can be
+    included, and each one only uses up one of the undecided edges of the row's city. The walk stops as soon as the row's city cannot give 
+    up another edge or the excluded chain can no longer beat the best route, since every later child would carry those exclusions. If every
+    cell is excluded, the node is a child too, and moves on to the next row when it is popped. The surviving children are queued together,
+    under one lock.
+
+    Only used with row-major branching, whose next edge is always the next cell of the row (see updateNodeConstraint()).
+*/
+void TravelingSalesmanSolver::expandRow(node &nodeX, int id)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    RowMask allCities = numberOfCities == MAX_CITIES ? ~RowMask(0) : (RowMask(1) << numberOfCities) - 1;
+    Configuration configuration = configurationOf(nodeX);
+    int row = nodeX.constraint.first;
+
+    RowMask open = 0; // Cities that can still take an edge
+    RowMask spare = 0; // Cities that keep enough undecided edges to give one up
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        open |= RowMask(configuration.includeColumn[city] < 2) << city;
+        spare |= RowMask(configuration.includeColumn[city] + configuration.excludeColumn[city] - 1 >= 2) << city;
+    }
+    RowMask undecided = allCities & ~((RowMask(1) << nodeX.constraint.second) - 1) & ~(configuration.includedEdges[row] | configuration.excludedEdges[row]);
+    RowMask includable = ((open >> row) & 1) ? undecided & open : 0;
+    if (nodeX.includedEdgeCount < numberOfCities - 1)
+    {
+        includable &= ~(RowMask(1) << configuration.fragmentEnd[row]); // The edge would close the row's fragment into a subtour (see checkForCycles())
+    }
+    int exclusionsLeft = configuration.includeColumn[row] + configuration.excludeColumn[row] - 2; // Edges the row's city can give up
+
+    node children[MAX_CITIES];
+    int numberOfChildren = 0;
+    bool excludedRow = true; // Whether nodeX is still alive with every cell walked so far excluded
+    for (RowMask cells = undecided; cells != 0; cells &= cells - 1)
+    {
+        nodeX.constraint.second = __builtin_ctzll(cells);
+        nodeX.include = (includable >> nodeX.constraint.second) & 1;
+        nodeX.exclude = exclusionsLeft > 0 && ((spare >> nodeX.constraint.second) & 1);
+
+        if (nodeX.include)
+        {
+            node includeNode = nodeX.exclude ? cloneNode(nodeX, id) : nodeX; // The last child takes over the popped node's arena block
+            if (boundChild(includeNode, true, id))
+            {
+                children[numberOfChildren++] = includeNode;
+            }
+        }
+        else if (programVariables.logLevel == LOG_TRACE)
+        {
+            programVariables.traceLog.record(id, TRACE_CANNOT_INCLUDE, nodeX);
+        }
+
+        if (!nodeX.exclude)
+        {
+            if (programVariables.logLevel == LOG_TRACE)
+            {
+                programVariables.traceLog.record(id, TRACE_CANNOT_EXCLUDE, nodeX);
+            }
+            if (!nodeX.include)
+            {
+                programVariables.nodeArena.release(nodeX.configurationSlot, id);
+            }
+            excludedRow = false;
+            break;
+        }
+        exclusionsLeft--;
+        if (!boundChild(nodeX, false, id))
+        {
+            excludedRow = false;
+            break;
+        }
+    }
+    if (excludedRow)
+    {
+        children[numberOfChildren++] = nodeX;
+    }
+
+    pushUnprocessedNodes(children, numberOfChildren, id);
+}
+
+/*
+    Hashes a value with a seed for the signatures of dominatedByCheaperNode().
+*/
+inline uint64_t mixSignature(uint64_t seed, uint64_t value)
+{
+    uint64_t hash = (seed ^ value) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (hash >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return hash ^ (hash >> 32);
+}
+
+/*
+    Looks the node up in the dominanceCache and records it there unless a cheaper node with the same signature is already recorded, in 
+    which case the node can be dropped (see DominanceCache): every route through it maps to a route through the cheaper node that differs 
+    only inside the fragments, and costs less. The cities that still take an edge are the "open" ones (fewer than two edges included). The
+    signature covers the closed cities, the far end of the fragment of each open city, and the excluded edges between open cities; the cost
+    is that of the included edges. Ties are kept, so a node looked up again (when a queued node is searched depth-first) is not dropped by 
+    its own entry. Returns false when the cache is off.
+*/
+bool TravelingSalesmanSolver::dominatedByCheaperNode(const node &nodeX, int id)
+{
+    if (!programVariables.dominanceCache.enabled())
+    {
+        return false;
+    }
+
+    // Written without data-dependent branches: which cities are open is different from one node to the next and would be mispredicted
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    Configuration configuration = configurationOf(nodeX);
+    RowMask open = 0;
+    long long doubledCost = 0; // Every included edge is counted from both of its cities
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        open |= RowMask(configuration.includeColumn[city] < 2) << city;
+        const int *costs = programVariables.adjacencyMatrix[city];
+        RowMask first = configuration.includedEdges[city] & (0 - configuration.includedEdges[city]); // A city has at most two included edges
+        RowMask second = configuration.includedEdges[city] ^ first;
+        doubledCost += (costs[63 - __builtin_clzll(first | 1)] & -int(first != 0)) + (costs[63 - __builtin_clzll(second | 1)] & -int(second != 0));
+    }
+
+    // Each open city hashes to its own term, so the terms do not wait on one another. The signature adds them up and the check xors them
+    uint64_t signature = mixSignature(0x243F6A8885A308D3ULL, open);
+    uint64_t check = mixSignature(0x13198A2E03707344ULL, open);
+    for (RowMask remaining = open; remaining != 0; remaining &= remaining - 1)
+    {
+        int city = __builtin_ctzll(remaining);
+        uint64_t excluded = configuration.excludedEdges[city] & open;
+        uint64_t term = mixSignature((uint64_t(city) << 8) | configuration.fragmentEnd[city], excluded); // An open city with no edge is its own end
+        signature += term;
+        check ^= term;
+    }
+
+    bool evicted = false;
+    bool dominated = programVariables.dominanceCache.dominated(signature, check, doubledCost / 2, evicted);
+    SearchCounters &counters = *programVariables.searchCounters[id];
+    addToCounter(dominated ? counters.dominanceHits : counters.dominanceMisses, 1);
+    if (evicted)
+    {
+        addToCounter(counters.dominanceEvictions, 1);
+    }
+    return dominated;
+}
+
+/*
+    Empties the cache and sizes it to the largest power of two of buckets that fits in the given number of bytes (0 turns it off). Each 
+    bucket fills one cache line, so a lookup touches one line of the table. The table comes from calloc(), which hands large blocks over as
+    untouched zero pages: only the pages the search reaches are ever cleared, so a large cache costs nothing on a small instance.
+*/
+void DominanceCache::reset(long long bytes)
+{
+    numberOfBuckets = 0;
+    while (bytes > 0 && (numberOfBuckets == 0 || numberOfBuckets * 2 * sizeof(Entry) * DOMINANCE_CACHE_WAYS <= size_t(bytes)))
+    {
+        numberOfBuckets = numberOfBuckets == 0 ? 1 : numberOfBuckets * 2;
+    }
+    entries.reset(); // Frees the old table before taking the new one
+    firstBucket = NULL;
+    if (numberOfBuckets == 0)
+    {
+        return;
+    }
+    // Zeroed: every entry is empty. The extra bucket leaves room to start the first one on a cache line
+    entries.reset(static_cast<Entry *>(std::calloc((numberOfBuckets + 1) * DOMINANCE_CACHE_WAYS, sizeof(Entry))));
+    if (!entries)
+    {
+        std::cerr << "Could not allocate a dominance cache of " << (bytes >> 20) << " MB; searching without one." << std::endl;
+        numberOfBuckets = 0;
+        return;
+    }
+    firstBucket = entries.get();
+    while (reinterpret_cast<uintptr_t>(firstBucket) % (sizeof(Entry) * DOMINANCE_CACHE_WAYS) != 0)
+    {
+        firstBucket++;
+    }
+}
+
+/*
+    Whether an entry with the same signature and check holds a cost below the given one. If not, the entry is created or lowered to the 
+    given cost; in a full bucket the most expensive entry makes room, and evicted is set. Costs that do not fit an entry are never recorded.
+*/
+bool DominanceCache::dominated(uint64_t signature, uint64_t check, long long cost, bool &evicted)
+{
+    if (cost > std::numeric_limits<int>::max())
+    {
+        return false;
+    }
+    signature |= 1; // 0 marks an empty entry
+    size_t bucket = size_t(signature >> 16) & (numberOfBuckets - 1); // The low bits went into telling entries apart
+    Entry *ways = firstBucket + bucket * DOMINANCE_CACHE_WAYS;
+    std::lock_guard<std::mutex> lock(locks[bucket % DOMINANCE_CACHE_LOCKS]);
+
+    Entry *replaced = NULL;
+    for (int way = 0; way < DOMINANCE_CACHE_WAYS; way++)
+    {
+        if (ways[way].signature == signature && ways[way].check == uint32_t(check))
+        {
+            if (ways[way].cost < cost)
+            {
+                return true;
+            }
+            ways[way].cost = int(cost);
+            return false;
+        }
+        if (replaced == NULL || (replaced->signature != 0 && (ways[way].signature == 0 || ways[way].cost > replaced->cost)))
+        {
+            replaced = &ways[way];
+        }
+    }
+
+    evicted = replaced->signature != 0;
+    replaced->signature = signature;
+    replaced->check = uint32_t(check);
+    replaced->cost = int(cost);
+    return false;
+}
+
+/*
+    Each time an edge is included or excluded, this method is called to update the configurationMatrix for that node. 
+    If an edge is included, two cells are modified with '1s' (X -> Y and Y -> X, given by the constraint). The same is true
+    for excluded edges, except two cells are modified with '-1s'. In the compact layout a '1' is a bit set in includedEdges and a '-1' 
+    is a bit set in excludedEdges.
+
+    In addition, each modification to the matrix must updated the last two columns (include and exclude columns). If an edge
+    is added, the include column is incremented, and the exclude column decremented. Again, since we are modifying two cells in two
+    different rows, these columns must be updated for each row. If an edge is excluded, the exclude column only need to be decremented
+    in each of the rows.
+
+    An included edge joins the fragments ending at its two cities. Unless the joined fragment already runs through every city, the edge between
+    its two ends would close it into a subtour, so that edge is excluded right away (if it is still undecided). The returned MatrixChange 
+    records what was done.
+*/
+MatrixChange TravelingSalesmanSolver::modifyMatrix(node &nodeX, bool include)
+{
+    int currentRow = nodeX.constraint.first;
+    int currentColumn = nodeX.constraint.second;
+    Configuration configuration = configurationOf(nodeX);
+    RowMask *edges = include ? configuration.includedEdges : configuration.excludedEdges;
+    MatrixChange change;
+    change.forbiddenEdge = std::make_pair(-1, -1);
+    change.rows[0] = currentRow;
+    change.rows[1] = currentColumn;
+    change.numberOfRows = 2;
+
+    edges[currentRow] |= RowMask(1) << currentColumn; // Sets current cell
+    edges[currentColumn] |= RowMask(1) << currentRow; // Sets the symmetrical cell
+
+    if(include)
+    {
+        configuration.includeColumn[currentRow] += 1; // Increments includeColumn
+        configuration.includeColumn[currentColumn] += 1; // Same for symmetrical cell
+    }
+
+    configuration.excludeColumn[currentRow] -= 1; // Decrements excludeColumn 
+    configuration.excludeColumn[currentColumn] -= 1; // Same for symmetrical cell
+
+    if (!include)
+    {
+        return change;
+    }
+
+    // The far ends of the two fragments become the ends of the joined fragment
+    int rowEnd = configuration.fragmentEnd[currentRow];
+    int columnEnd = configuration.fragmentEnd[currentColumn];
+    change.fragmentEnds[0] = rowEnd;
+    change.fragmentEnds[1] = columnEnd;
+    configuration.fragmentEnd[rowEnd] = columnEnd;
+    configuration.fragmentEnd[columnEnd] = rowEnd;
+    nodeX.includedEdgeCount++;
+
+    RowMask closingEdge = RowMask(1) << columnEnd;
+    bool undecided = ((configuration.includedEdges[rowEnd] | configuration.excludedEdges[rowEnd]) & closingEdge) == 0;
+    if (nodeX.includedEdgeCount < programVariables.numberOfCitiesToVisit - 1 && undecided)
+    {
+        configuration.excludedEdges[rowEnd] |= closingEdge;
+        configuration.excludedEdges[columnEnd] |= RowMask(1) << rowEnd;
+        configuration.excludeColumn[rowEnd] -= 1;
+        configuration.excludeColumn[columnEnd] -= 1;
+        change.forbiddenEdge = std::make_pair(rowEnd, columnEnd);
+        for (int i = 0; i < 2; i++)
+        {
+            int row = i == 0 ? rowEnd : columnEnd;
+            if (row != currentRow && row != currentColumn)
+            {
+                change.rows[change.numberOfRows++] = row;
+            }
+        }
+    }
+
+    return change;
+}
+
+/*
+    Reverses modifyMatrix() for the node's constraint: the two cells go back to '0', the include and exclude columns of both rows are restored,
+    and an include's fragment join and forbidden edge are taken back. Used by the depth-first search to backtrack.
+*/
+void TravelingSalesmanSolver::undoModifyMatrix(node &nodeX, bool include, const MatrixChange &change)
+{
+    int currentRow = nodeX.constraint.first;
+    int currentColumn = nodeX.constraint.second;
+    Configuration configuration = configurationOf(nodeX);
+    RowMask *edges = include ? configuration.includedEdges : configuration.excludedEdges;
+
+    edges[currentRow] &= ~(RowMask(1) << currentColumn);
+    edges[currentColumn] &= ~(RowMask(1) << currentRow);
+
+    if(include)
+    {
+        configuration.includeColumn[currentRow] -= 1;
+        configuration.includeColumn[currentColumn] -= 1;
+
+        // Each far end pointed back at the city the edge was added to before the join (a city with no edge is its own far end)
+        configuration.fragmentEnd[change.fragmentEnds[0]] = currentRow;
+        configuration.fragmentEnd[change.fragmentEnds[1]] = currentColumn;
+        nodeX.includedEdgeCount--;
+    }
+
+    configuration.excludeColumn[currentRow] += 1;
+    configuration.excludeColumn[currentColumn] += 1;
+
+    if (change.forbiddenEdge.first >= 0)
+    {
+        configuration.excludedEdges[change.forbiddenEdge.first] &= ~(RowMask(1) << change.forbiddenEdge.second);
+        configuration.excludedEdges[change.forbiddenEdge.second] &= ~(RowMask(1) << change.forbiddenEdge.first);
+        configuration.excludeColumn[change.forbiddenEdge.first] += 1;
+        configuration.excludeColumn[change.forbiddenEdge.second] += 1;
+    }
+}
+
+/*
+    Half of a bound's sum, rounded up. Integer division truncates towards zero, which rounds a negative half up already, so only a positive 
+    sum needs the extra one.
+*/
+inline long long halfRoundedUp(long long total)
+{
+    return total >= 0 ? (total + 1) / 2 : -((-total) / 2);
+}
+
+/*
+    The lower bound of a node is half the sum, over all cities, of the two cheapest edges each city can still use. An included edge must be used,
+    so it always counts towards its city's two; an excluded edge can never be used. Every tour uses exactly two edges per city and counts each edge 
+    twice in that sum, so no route below the node can cost less than the bound. Once every edge is decided, the bound is the cost of the route.
+
+    This method computes the bound from scratch (used for the root). Children only change a few rows, see calculateLowerBoundForNodeUpdated().
+*/
+void TravelingSalesmanSolver::calculateLowerBoundForNode(node &nodeX)
+{
+    Configuration configuration = configurationOf(nodeX);
+    long long total = 0;
+
+    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
+    {
+        configuration.rowLowerBound[row] = calculateRowLowerBound(configuration, row);
+        total += configuration.rowLowerBound[row];
+    }
+
+    *configuration.lowerBoundTotal = total >= UNUSABLE_EDGE ? UNUSABLE_EDGE : int(total);
+    nodeX.lowerBound = total >= UNUSABLE_EDGE ? std::numeric_limits<double>::infinity() : double(halfRoundedUp(total)); // Tour costs are whole numbers, so half the sum can be rounded up
+}
+
+/*
+    Updates the bound after modifyMatrix() changed the cell given by the constraint. Only the rows listed in the change (the two rows of that cell,
+    and those of an edge it forbade) can change, so only those rows are rescanned and the cached total is adjusted by the difference.
+*/
+void TravelingSalesmanSolver::calculateLowerBoundForNodeUpdated(node &nodeX, const MatrixChange &change)
+{
+    Configuration configuration = configurationOf(nodeX);
+    int total = *configuration.lowerBoundTotal;
+    const int *rows = change.rows;
+
+    for (int i = 0; i < change.numberOfRows && total != UNUSABLE_EDGE; i++)
+    {
+        int rowBound = calculateRowLowerBound(configuration, rows[i]);
+        long long updated = (long long)total - configuration.rowLowerBound[rows[i]] + rowBound;
+
+        configuration.rowLowerBound[rows[i]] = rowBound;
+        total = (rowBound == UNUSABLE_EDGE || updated >= UNUSABLE_EDGE) ? UNUSABLE_EDGE : int(updated);
+    }
+
+    *configuration.lowerBoundTotal = total;
+    nodeX.lowerBound = total == UNUSABLE_EDGE ? std::numeric_limits<double>::infinity() : double(halfRoundedUp(total));
+}
+
+/*
+    Lookup table used to expand a RowMask into one int per column, eight columns at a time: entry [b][k] is all ones if bit k of b is set
+    and 0 otherwise. Selecting UNUSABLE_EDGE wherever the expanded mask is set blanks out every blocked column without a branch, whatever 
+    the sign of the costs.
+*/
+struct RowMaskLanes {
+    int lanes[256][8];
+
+    RowMaskLanes()
+    {
+        for (int bits = 0; bits < 256; bits++)
+        {
+            for (int k = 0; k < 8; k++)
+            {
+                lanes[bits][k] = (bits >> k) & 1 ? -1 : 0;
+            }
+        }
+    }
+};
+
+const RowMaskLanes rowMaskLanes;
+
+/*
+    Returns the cost of the two cheapest edges a city can still use: its included edges plus the cheapest edges that are neither included nor 
+    excluded. Returns UNUSABLE_EDGE if the city cannot be given two edges any more.
+
+    The scan over the row is written as two branch-free passes over contiguous ints (a minimum, then a tie count and the next larger value), 
+    which the compiler turns into SIMD min/compare/select instructions. Costs may be negative.
+*/
+int TravelingSalesmanSolver::calculateRowLowerBound(const Configuration &configuration, int row)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    const int *costs = programVariables.adjacencyMatrix[row];
+    RowMask included = configuration.includedEdges[row];
+    int includedCost = 0;
+    int needed = 2;
+
+    for (RowMask edges = included; edges != 0 && needed > 0; edges &= edges - 1, needed--)
+    {
+        includedCost += costs[__builtin_ctzll(edges)];
+    }
+    if (needed == 0)
+    {
+        return includedCost;
+    }
+
+    RowMask blocked = included | configuration.excludedEdges[row] | (RowMask(1) << row);
+    int blockedLanes[MAX_CITIES];
+    for (int column = 0; column < numberOfCities; column += 8)
+    {
+        std::memcpy(blockedLanes + column, rowMaskLanes.lanes[(blocked >> column) & 0xFF], sizeof(rowMaskLanes.lanes[0]));
+    }
+
+    int cheapest = UNUSABLE_EDGE;
+    for (int column = 0; column < numberOfCities; column++)
+    {
+        int cost = (costs[column] & ~blockedLanes[column]) | (UNUSABLE_EDGE & blockedLanes[column]); // Select UNUSABLE_EDGE where blocked
+        cheapest = cost < cheapest ? cost : cheapest;
+    }
+    if (cheapest == UNUSABLE_EDGE)
+    {
+        return UNUSABLE_EDGE;
+    }
+    if (needed == 1)
+    {
+        return includedCost + cheapest;
+    }
+
+    int ties = 0;
+    int nextCheapest = UNUSABLE_EDGE;
+    for (int column = 0; column < numberOfCities; column++)
+    {
+        int cost = (costs[column] & ~blockedLanes[column]) | (UNUSABLE_EDGE & blockedLanes[column]);
+        int notAbove = -(cost <= cheapest);
+        int above = (cost & ~notAbove) | (UNUSABLE_EDGE & notAbove); // Costs that are not above the cheapest become UNUSABLE_EDGE
+        ties += cost == cheapest;
+        nextCheapest = above < nextCheapest ? above : nextCheapest;
+    }
+    if (ties > 1)
+    {
+        nextCheapest = cheapest; // Two usable edges share the cheapest cost
+    }
+    if (nextCheapest == UNUSABLE_EDGE)
+    {
+        return UNUSABLE_EDGE;
+    }
+
+    return includedCost + cheapest + nextCheapest;
+}
+
+/*
+    Held-Karp bound. A 1-tree is a spanning tree over cities 1..N-1 plus the two cheapest edges from city 0; every route is a 1-tree, so the 
+    cheapest 1-tree that uses all included edges and no excluded edge is a lower bound for the node. Adding a penalty to every edge of a city
+    does not change which route is best (every route uses two edges per city), but it does change the 1-tree; the subgradient method below
+    raises the penalty of cities with more than two tree edges and lowers it for leaves, pushing the 1-tree towards a route and the bound upwards.
+
+    The penalties are kept in the node's block and copied into its children, so each child starts from its parent's penalties and only needs a
+    few iterations. The node's lowerBound becomes the larger of the two-cheapest-edges bound and the best 1-tree bound found. If a 1-tree turns
+    out to be a route, it is the best route below this node, so it is handed to updateFoundRoute() and no further bounding is needed.
+*/
+void TravelingSalesmanSolver::calculateOneTreeBound(node &nodeX, int iterations, int id)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    Configuration configuration = configurationOf(nodeX);
+    double *penalties = configuration.penalties;
+    double bestPenalties[MAX_CITIES];
+    int degrees[MAX_CITIES];
+    int treeNeighbour[2 * MAX_CITIES];
+    double bestBound = -std::numeric_limits<double>::infinity();
+    double stepScale = iterations >= ROOT_SUBGRADIENT_ITERATIONS ? 2.0 : 0.5; // Children start close to good penalties, so they take smaller steps
+    int iterationsWithoutImprovement = 0;
+
+    if (nodeX.lowerBound == std::numeric_limits<double>::infinity())
+    {
+        return; // The two-cheapest-edges bound already shows the node has no route
+    }
+
+    std::copy(penalties, penalties + numberOfCities, bestPenalties);
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        double bound = calculateOneTree(configuration, penalties, degrees, treeNeighbour);
+        if (bound == std::numeric_limits<double>::infinity())
+        {
+            nodeX.lowerBound = bound; // The included and excluded edges leave no 1-tree, so there is no route below this node
+            return;
+        }
+
+        int squaredDegreeError = 0;
+        for (int city = 0; city < numberOfCities; city++)
+        {
+            squaredDegreeError += (degrees[city] - 2) * (degrees[city] - 2);
+        }
+        if (squaredDegreeError == 0) // Every city has two edges: the 1-tree is a route
+        {
+            recordOneTreeRoute(nodeX, treeNeighbour, id);
+            return;
+        }
+
+        if (bound > bestBound + 1e-9)
+        {
+            bestBound = bound;
+            std::copy(penalties, penalties + numberOfCities, bestPenalties);
+            iterationsWithoutImprovement = 0;
+        }
+        else if (++iterationsWithoutImprovement >= 5)
+        {
+            stepScale /= 2;
+            iterationsWithoutImprovement = 0;
+        }
+        if (std::ceil(bestBound - 1e-6) >= programVariables.bestRouteCost.load())
+        {
+            break; // Already enough to prune the node
+        }
+
+        double target = programVariables.bestRouteCost.load();
+        if (target == std::numeric_limits<double>::infinity() || target <= bound)
+        {
+            target = bound + std::fabs(bound) * 0.05 + 1; // No route to aim for yet; above the bound whatever its sign
+        }
+        double step = stepScale * (target - bound) / squaredDegreeError;
+        for (int city = 0; city < numberOfCities; city++)
+        {
+            penalties[city] += step * (degrees[city] - 2);
+        }
+    }
+
+    std::copy(bestPenalties, bestPenalties + numberOfCities, penalties); // Children warm-start from the penalties that gave the best bound
+    nodeX.lowerBound = std::max(nodeX.lowerBound, std::ceil(bestBound - 1e-6)); // Route costs are whole numbers; the slack absorbs rounding error
+}
+
+/*
+    Builds the cheapest 1-tree under the given penalties and returns its penalized cost minus twice the sum of the penalties (the Held-Karp bound),
+    or infinity if no 1-tree respects the node's edges. degrees receives each city's degree in the 1-tree, and treeNeighbour the tree itself: 
+    for city c > 1 in the spanning tree, treeNeighbour[c] is its parent; treeNeighbour[N] and treeNeighbour[N + 1] are the two cities joined to city 0.
+
+    Included edges must be in the tree and are taken before any other edge by Prim's algorithm (they never form a cycle, see checkForCycles()). 
+    Excluded edges are skipped, as are the remaining edges of a city that already has two included edges.
+*/
+double TravelingSalesmanSolver::calculateOneTree(const Configuration &configuration, const double *penalties, int *degrees, int *treeNeighbour)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    const double infinity = std::numeric_limits<double>::infinity();
+    RowMask allowed[MAX_CITIES];
+    double key[MAX_CITIES];
+    bool keyIncluded[MAX_CITIES];
+    bool inTree[MAX_CITIES];
+    double total = 0;
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        allowed[city] = configuration.includeColumn[city] >= 2 ? configuration.includedEdges[city] : ~(configuration.excludedEdges[city] | (RowMask(1) << city));
+        degrees[city] = 0;
+        total -= 2 * penalties[city];
+    }
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        for (int other = 0; other < numberOfCities; other++) // An edge is only usable if neither end rules it out
+        {
+            if (!(allowed[other] & (RowMask(1) << city)))
+            {
+                allowed[city] &= ~(RowMask(1) << other);
+            }
+        }
+    }
+
+    // Prim's algorithm over cities 1..N-1, starting from city 1
+    for (int city = 1; city < numberOfCities; city++)
+    {
+        key[city] = infinity;
+        keyIncluded[city] = false;
+        inTree[city] = false;
+    }
+    key[1] = 0;
+    treeNeighbour[1] = 1;
+    for (int added = 1; added < numberOfCities; added++)
+    {
+        int next = -1;
+        for (int city = 1; city < numberOfCities; city++)
+        {
+            if (!inTree[city] && key[city] != infinity && (next == -1 || keyIncluded[city] > keyIncluded[next] || (keyIncluded[city] == keyIncluded[next] && key[city] < key[next])))
+            {
+                next = city;
+            }
+        }
+        if (next == -1)
+        {
+            return infinity; // The allowed edges do not connect cities 1..N-1
+        }
+
+        inTree[next] = true;
+        total += key[next];
+        if (next != 1)
+        {
+            degrees[next]++;
+            degrees[treeNeighbour[next]]++;
+        }
+
+        const int *costs = programVariables.adjacencyMatrix[next];
+        for (int city = 1; city < numberOfCities; city++)
+        {
+            if (inTree[city] || !(allowed[next] & (RowMask(1) << city)))
+            {
+                continue;
+            }
+            bool included = (configuration.includedEdges[next] & (RowMask(1) << city)) != 0;
+            double cost = costs[city] + penalties[next] + penalties[city];
+            if (included > keyIncluded[city] || (included == keyIncluded[city] && cost < key[city]))
+            {
+                key[city] = cost;
+                keyIncluded[city] = included;
+                treeNeighbour[city] = next;
+            }
+        }
+    }
+
+    // The two edges of city 0: included ones first, then the cheapest allowed ones
+    const int *costs = programVariables.adjacencyMatrix[0];
+    int chosen = 0;
+    for (RowMask edges = configuration.includedEdges[0]; edges != 0 && chosen < 2; edges &= edges - 1)
+    {
+        treeNeighbour[numberOfCities + chosen++] = __builtin_ctzll(edges);
+    }
+    while (chosen < 2)
+    {
+        int cheapest = -1;
+        for (int city = 1; city < numberOfCities; city++)
+        {
+            bool taken = chosen == 1 && treeNeighbour[numberOfCities] == city;
+            if (!taken && (allowed[0] & (RowMask(1) << city)) && (cheapest == -1 || costs[city] + penalties[city] < costs[cheapest] + penalties[cheapest]))
+            {
+                cheapest = city;
+            }
+        }
+        if (cheapest == -1)
+        {
+            return infinity;
+        }
+        treeNeighbour[numberOfCities + chosen++] = cheapest;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        int city = treeNeighbour[numberOfCities + i];
+        total += costs[city] + penalties[0] + penalties[city];
+        degrees[0]++;
+        degrees[city]++;
+    }
+
+    return total;
+}
+
+/*
+    Turns a 1-tree in which every city has two edges into a route node and offers it to updateFoundRoute(). The node itself is given the route's 
+    cost as its bound, since no route below it can be cheaper.
+*/
+void TravelingSalesmanSolver::recordOneTreeRoute(node &nodeX, const int *treeNeighbour, int id)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    std::pair<int, int> edges[MAX_CITIES];
+
+    for (int edge = 2; edge < numberOfCities + 2; edge++) // Tree edges of cities 2..N-1 to their parents, then the two edges of city 0
+    {
+        edges[edge - 2] = std::make_pair(edge < numberOfCities ? edge : 0, treeNeighbour[edge]);
+    }
+
+    node route = createRouteNode(edges, id);
+    nodeX.lowerBound = route.lowerBound;
+    updateFoundRoute(route, id);
+}
+
+/*
+    Creates a node whose configurationMatrix includes exactly the given N edges (a complete route) and excludes every other edge. Its lowerBound is the 
+    cost of the route.
+*/
+node TravelingSalesmanSolver::createRouteNode(const std::pair<int, int> *edges, int id)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    RowMask allCities = numberOfCities == MAX_CITIES ? ~RowMask(0) : (RowMask(1) << numberOfCities) - 1;
+    node route;
+    route.configurationSlot = programVariables.nodeArena.allocate(id);
+    Configuration configuration = configurationOf(route);
+    int cost = 0;
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        configuration.includedEdges[city] = 0;
+    }
+    for (int edge = 0; edge < numberOfCities; edge++)
+    {
+        int from = edges[edge].first;
+        int to = edges[edge].second;
+        configuration.includedEdges[from] |= RowMask(1) << to;
+        configuration.includedEdges[to] |= RowMask(1) << from;
+        cost += programVariables.adjacencyMatrix[from][to];
+    }
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        configuration.excludedEdges[city] = allCities & ~configuration.includedEdges[city] & ~(RowMask(1) << city);
+        configuration.includeColumn[city] = 2;
+        configuration.excludeColumn[city] = 0;
+        configuration.fragmentEnd[city] = city; // The route has no fragment ends; every city only points at itself
+    }
+    if (configuration.penalties != NULL)
+    {
+        std::fill(configuration.penalties, configuration.penalties + numberOfCities, 0.0);
+    }
+    calculateLowerBoundForNode(route); // With every edge decided, this is the cost of the route
+
+    route.lowerBound = cost;
+    route.constraint = std::make_pair(numberOfCities - 2, numberOfCities - 1);
+    route.include = false;
+    route.exclude = false;
+    route.includedEdgeCount = numberOfCities;
+    return route;
+}
+
+/*
+    Builds a good route before the branch-and-bound search starts, so that pruneNodesUpdated() can prune from the first node instead of waiting 
+    for the search to complete a route. The route is built by nearest neighbour from city 0 and then improved with 2-opt and Or-opt moves until 
+    neither finds an improvement. Both moves only try to connect a city to one of its nearest neighbours (see buildNeighbourLists()).
+*/
+void TravelingSalesmanSolver::seedFoundRouteWithHeuristic()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    std::vector<std::vector<int> > neighbours = buildNeighbourLists(std::min(NEIGHBOUR_LIST_SIZE, numberOfCities - 1));
+    std::vector<int> tour = nearestNeighbourTour();
+    int constructedCost = calculateTourCost(tour);
+
+    bool improved = true;
+    while (improved)
+    {
+        improved = improveTourWithTwoOpt(tour, neighbours);
+        improved = improveTourWithOrOpt(tour, neighbours) || improved;
+    }
+
+    std::pair<int, int> edges[MAX_CITIES];
+    for (int i = 0; i < numberOfCities; i++)
+    {
+        edges[i] = std::make_pair(tour[i], tour[(i + 1) % numberOfCities]);
+    }
+    node route = createRouteNode(edges, 0);
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Starting route: nearest neighbour " << constructedCost << ", after 2-opt/Or-opt " << route.lowerBound << std::endl << std::endl;
+    }
+    updateFoundRoute(route, 0);
+}
+
+/*
+    For each city, lists the size closest other cities, nearest first.
+*/
+std::vector<std::vector<int> > TravelingSalesmanSolver::buildNeighbourLists(int size)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    std::vector<std::vector<int> > neighbours(numberOfCities);
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        const int *costs = programVariables.adjacencyMatrix[city];
+        std::vector<int> &list = neighbours[city];
+        for (int other = 0; other < numberOfCities; other++)
+        {
+            if (other != city)
+            {
+                list.push_back(other);
+            }
+        }
+        std::partial_sort(list.begin(), list.begin() + size, list.end(), [&costs](int a, int b) { return costs[a] < costs[b]; });
+        list.resize(size);
+    }
+
+    return neighbours;
+}
+
+/*
+    Starting from city 0, repeatedly travels to the cheapest city not yet visited.
+*/
+std::vector<int> TravelingSalesmanSolver::nearestNeighbourTour()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    std::vector<int> tour(1, 0);
+    std::vector<bool> visited(numberOfCities, false);
+    visited[0] = true;
+
+    while (int(tour.size()) < numberOfCities)
+    {
+        const int *costs = programVariables.adjacencyMatrix[tour.back()];
+        int nearest = -1;
+        for (int city = 0; city < numberOfCities; city++)
+        {
+            if (!visited[city] && (nearest == -1 || costs[city] < costs[nearest]))
+            {
+                nearest = city;
+            }
+        }
+        visited[nearest] = true;
+        tour.push_back(nearest);
+    }
+
+    return tour;
+}
+
+int TravelingSalesmanSolver::calculateTourCost(const std::vector<int> &tour)
+{
+    int cost = 0;
+    for (size_t i = 0; i < tour.size(); i++)
+    {
+        cost += programVariables.adjacencyMatrix[tour[i]][tour[(i + 1) % tour.size()]];
+    }
+    return cost;
+}
+
+/*
+    2-opt: removes two edges (a, b) and (c, d) of the tour and reconnects it as (a, c) and (b, d) by reversing the path between them. Only cities 
+    c from a's neighbour list that are closer to a than b is are tried, since otherwise the move cannot gain. Returns true if the tour improved.
+*/
+bool TravelingSalesmanSolver::improveTourWithTwoOpt(std::vector<int> &tour, const std::vector<std::vector<int> > &neighbours)
+{
+    int numberOfCities = tour.size();
+    std::vector<int> position(numberOfCities);
+    bool anyImprovement = false;
+    bool improved = true;
+
+    for (int i = 0; i < numberOfCities; i++)
+    {
+        position[tour[i]] = i;
+    }
+
+    while (improved)
+    {
+        improved = false;
+        for (int i = 0; i < numberOfCities; i++)
+        {
+            int a = tour[i];
+            int b = tour[(i + 1) % numberOfCities];
+            int costAB = programVariables.adjacencyMatrix[a][b];
+
+            for (size_t k = 0; k < neighbours[a].size(); k++)
+            {
+                int c = neighbours[a][k];
+                int costAC = programVariables.adjacencyMatrix[a][c];
+                if (costAC >= costAB)
+                {
+                    break;
+                }
+
+                int j = position[c];
+                int d = tour[(j + 1) % numberOfCities];
+                if (c == b || d == a)
+                {
+                    continue;
+                }
+                if (costAC + programVariables.adjacencyMatrix[b][d] < costAB + programVariables.adjacencyMatrix[c][d])
+                {
+                    // Reversing positions i+1..j, or equivalently the rest of the tour j+1..i when the path wraps around
+                    int first = i < j ? i + 1 : j + 1;
+                    int last = i < j ? j : i;
+                    std::reverse(tour.begin() + first, tour.begin() + last + 1);
+                    for (int p = first; p <= last; p++)
+                    {
+                        position[tour[p]] = p;
+                    }
+                    improved = true;
+                    anyImprovement = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    return anyImprovement;
+}
+
+/*
+    Or-opt: moves a segment of one to three consecutive cities to another place in the tour (between c and the city after it, possibly reversed),
+    when that is cheaper. c is taken from the neighbour lists of the segment's two end cities. Returns true if the tour improved.
+*/
+bool TravelingSalesmanSolver::improveTourWithOrOpt(std::vector<int> &tour, const std::vector<std::vector<int> > &neighbours)
+{
+    int numberOfCities = tour.size();
+    bool anyImprovement = false;
+    bool improved = true;
+    const DistanceOracle &cost = programVariables.adjacencyMatrix;
+
+    while (improved)
+    {
+        improved = false;
+        for (int length = 1; length <= 3 && length + 2 < numberOfCities && !improved; length++)
+        {
+            for (int start = 0; start < numberOfCities && !improved; start++)
+            {
+                int first = tour[start];
+                int last = tour[(start + length - 1) % numberOfCities];
+                int before = tour[(start + numberOfCities - 1) % numberOfCities];
+                int after = tour[(start + length) % numberOfCities];
+                int removalGain = cost[before][first] + cost[last][after] - cost[before][after];
+
+                for (int end = 0; end < 2 && !improved; end++)
+                {
+                    const std::vector<int> &candidates = neighbours[end == 0 ? first : last];
+                    for (size_t k = 0; k < candidates.size(); k++)
+                    {
+                        int c = candidates[k];
+                        int cPosition = std::find(tour.begin(), tour.end(), c) - tour.begin();
+                        int offset = (cPosition - start + numberOfCities) % numberOfCities;
+                        if (offset < length || c == before) // c is inside the segment, or the segment already follows it
+                        {
+                            continue;
+                        }
+                        int d = tour[(cPosition + 1) % numberOfCities];
+                        int forward = cost[c][first] + cost[last][d] - cost[c][d];
+                        int reversed = cost[c][last] + cost[first][d] - cost[c][d];
+                        if (std::min(forward, reversed) >= removalGain)
+                        {
+                            continue;
+                        }
+
+                        // Take the segment out (rotating the tour so it does not wrap), then insert it after c
+                        std::rotate(tour.begin(), tour.begin() + start, tour.end());
+                        std::vector<int> segment(tour.begin(), tour.begin() + length);
+                        tour.erase(tour.begin(), tour.begin() + length);
+                        if (reversed < forward)
+                        {
+                            std::reverse(segment.begin(), segment.end());
+                        }
+                        int insertAt = std::find(tour.begin(), tour.end(), c) - tour.begin() + 1;
+                        tour.insert(tour.begin() + insertAt, segment.begin(), segment.end());
+                        improved = true;
+                        anyImprovement = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return anyImprovement;
+}
+
+/*
+    Builds the tree over the given coordinates, splitting each node at the median of its wider side until a leaf holds at most 
+    CITY_TREE_LEAF_SIZE cities. No city is visited afterwards.
+*/
+void CityTree::build(const std::vector<std::pair<double, double> > &coordinates)
+{
+    points = coordinates;
+    cities.resize(points.size());
+    for (size_t i = 0; i < cities.size(); i++)
+    {
+        cities[i] = int(i);
+    }
+    nodes.clear();
+    nodes.reserve(4 * points.size() / CITY_TREE_LEAF_SIZE + 1);
+    leafOf.assign(points.size(), 0);
+    visited.assign(points.size(), false);
+    buildNode(0, int(points.size()), -1);
+}
+
+int CityTree::buildNode(int first, int last, int parent)
+{
+    TreeNode treeNode;
+    treeNode.first = first;
+    treeNode.last = last;
+    treeNode.left = -1;
+    treeNode.right = -1;
+    treeNode.parent = parent;
+    treeNode.minX = treeNode.minY = std::numeric_limits<double>::infinity();
+    treeNode.maxX = treeNode.maxY = -std::numeric_limits<double>::infinity();
+    treeNode.unvisited = last - first;
+    for (int i = first; i < last; i++)
+    {
+        const std::pair<double, double> &point = points[cities[i]];
+        treeNode.minX = std::min(treeNode.minX, point.first);
+        treeNode.maxX = std::max(treeNode.maxX, point.first);
+        treeNode.minY = std::min(treeNode.minY, point.second);
+        treeNode.maxY = std::max(treeNode.maxY, point.second);
+    }
+    int index = int(nodes.size());
+    nodes.push_back(treeNode);
+
+    if (last - first <= CITY_TREE_LEAF_SIZE)
+    {
+        for (int i = first; i < last; i++)
+        {
+            leafOf[cities[i]] = index;
+        }
+        return index;
+    }
+
+    bool splitOnX = treeNode.maxX - treeNode.minX >= treeNode.maxY - treeNode.minY;
+    int middle = first + (last - first) / 2;
+    const std::vector<std::pair<double, double> > &coordinates = points;
+    std::nth_element(cities.begin() + first, cities.begin() + middle, cities.begin() + last, [&coordinates, splitOnX](int a, int b) 
+        { return splitOnX ? coordinates[a].first < coordinates[b].first : coordinates[a].second < coordinates[b].second; });
+    int left = buildNode(first, middle, index);
+    int right = buildNode(middle, last, index);
+    nodes[index].left = left; // nodes may have moved while the children were built
+    nodes[index].right = right;
+    return index;
+}
+
+/*
+    Squared distance from a point to the bounding box of a node; 0 if the point is inside it.
+*/
+double CityTree::boxDistance(const TreeNode &treeNode, const std::pair<double, double> &point) const
+{
+    double dx = std::max(0.0, std::max(treeNode.minX - point.first, point.first - treeNode.maxX));
+    double dy = std::max(0.0, std::max(treeNode.minY - point.second, point.second - treeNode.maxY));
+    return dx * dx + dy * dy;
+}
+
+/*
+    Fills nearest with the count cities closest to city (city itself excluded), nearest first.
+*/
+void CityTree::nearestCities(int city, int count, std::vector<int> &nearest) const
+{
+    const std::pair<double, double> &point = points[city];
+    std::priority_queue<std::pair<double, int> > closest; // Farthest of the closest cities so far on top
+    std::vector<int> pending(1, 0);
+
+    while (!pending.empty())
+    {
+        const TreeNode &treeNode = nodes[pending.back()];
+        pending.pop_back();
+        if (int(closest.size()) == count && boxDistance(treeNode, point) >= closest.top().first)
+        {
+            continue;
+        }
+        if (treeNode.left == -1)
+        {
+            for (int i = treeNode.first; i < treeNode.last; i++)
+            {
+                int other = cities[i];
+                double dx = points[other].first - point.first;
+                double dy = points[other].second - point.second;
+                double distance = dx * dx + dy * dy;
+                if (other == city || (int(closest.size()) == count && distance >= closest.top().first))
+                {
+                    continue;
+                }
+                if (int(closest.size()) == count)
+                {
+                    closest.pop();
+                }
+                closest.push(std::make_pair(distance, other));
+            }
+            continue;
+        }
+        bool leftFirst = boxDistance(nodes[treeNode.left], point) <= boxDistance(nodes[treeNode.right], point);
+        pending.push_back(leftFirst ? treeNode.right : treeNode.left); // The nearer child is searched first, so the other is more often pruned
+        pending.push_back(leftFirst ? treeNode.left : treeNode.right);
+    }
+
+    nearest.resize(closest.size());
+    for (int i = int(closest.size()) - 1; i >= 0; i--)
+    {
+        nearest[i] = closest.top().second;
+        closest.pop();
+    }
+}
+
+void CityTree::resetVisits()
+{
+    visited.assign(points.size(), false);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        nodes[i].unvisited = nodes[i].last - nodes[i].first;
+    }
+}
+
+void CityTree::markVisited(int city)
+{
+    visited[city] = true;
+    for (int index = leafOf[city]; index != -1; index = nodes[index].parent)
+    {
+        nodes[index].unvisited--;
+    }
+}
+
+/*
+    Closest city to city that has not been visited; -1 once every city has been.
+*/
+int CityTree::nearestUnvisited(int city) const
+{
+    const std::pair<double, double> &point = points[city];
+    int nearest = -1;
+    double nearestDistance = std::numeric_limits<double>::infinity();
+    std::vector<int> pending(1, 0);
+
+    while (!pending.empty())
+    {
+        const TreeNode &treeNode = nodes[pending.back()];
+        pending.pop_back();
+        if (treeNode.unvisited == 0 || boxDistance(treeNode, point) >= nearestDistance)
+        {
+            continue;
+        }
+        if (treeNode.left == -1)
+        {
+            for (int i = treeNode.first; i < treeNode.last; i++)
+            {
+                int other = cities[i];
+                double dx = points[other].first - point.first;
+                double dy = points[other].second - point.second;
+                if (!visited[other] && dx * dx + dy * dy < nearestDistance)
+                {
+                    nearest = other;
+                    nearestDistance = dx * dx + dy * dy;
+                }
+            }
+            continue;
+        }
+        bool leftFirst = boxDistance(nodes[treeNode.left], point) <= boxDistance(nodes[treeNode.right], point);
+        pending.push_back(leftFirst ? treeNode.right : treeNode.left);
+        pending.push_back(leftFirst ? treeNode.left : treeNode.right);
+    }
+
+    return nearest;
+}
+
+/*
+    The Lin-Kernighan engine finds good routes, with no proof of optimality, for instances of any size. Each restart builds a nearest 
+    neighbour tour from a random city and improves it with Lin-Kernighan and Or-opt moves until neither helps (see optimizeTourLocally()); 
+    the restarts are shared by numberOfThreads threads and the best tour is kept in heuristicRoute. Moves only connect a city to its 
+    CANDIDATE_LIST_SIZE nearest cities, which a CityTree finds for coordinate instances, and distances are computed from the coordinates 
+    as they are needed, so nothing of size N x N is built. The time limit ends the restarts early; the node limit does not apply. Every 
+    improvement of the best tour is logged in routeHistory with its time, which gives the quality of the route against the elapsed time.
+*/
+void TravelingSalesmanSolver::linKernighanDispatcher()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CityTree cityTree;
+    if (!programVariables.cityCoordinates.empty())
+    {
+        cityTree.build(programVariables.cityCoordinates);
+    }
+    std::vector<int> candidates = buildCandidateLists(cityTree);
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Edge costs: " << DISTANCE_STORAGE_NAMES[programVariables.adjacencyMatrix.storageKind()] << " (" 
+            << programVariables.adjacencyMatrix.bytes() / 1024 << " KB)" << std::endl;
+        std::cout << "Candidate lists: " << candidates.size() / numberOfCities << " nearest cities per city, built in " 
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl << std::endl;
+    }
+
+    int restarts = programVariables.restarts > 0 ? programVariables.restarts : programVariables.numberOfThreads;
+    std::atomic<int> nextRestart(0);
+    std::vector<std::thread> workers;
+    for (int id = 1; id < std::min(programVariables.numberOfThreads, restarts); id++)
+    {
+        workers.push_back(std::thread(&TravelingSalesmanSolver::linKernighanWorker, this, id, std::cref(candidates), std::cref(cityTree), 
+            std::ref(nextRestart), restarts));
+    }
+    linKernighanWorker(0, candidates, cityTree, nextRestart, restarts);
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    programVariables.searchMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    programVariables.solveMilliseconds = std::chrono::duration<double, std::milli>(end - programVariables.solveStartTime).count();
+    programVariables.provenLowerBound = std::numeric_limits<double>::infinity(); // Nothing is proven about the route
+}
+
+/*
+    One thread of the Lin-Kernighan engine: takes restarts until all of them have been taken or the time limit is reached. Restart r 
+    seeds its random numbers with seed + r, so it builds and improves the same tour whichever thread runs it.
+*/
+void TravelingSalesmanSolver::linKernighanWorker(int id, const std::vector<int> &candidates, const CityTree &cityTree, std::atomic<int> &nextRestart, int restarts)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    CityTree visitTree = cityTree; // The nearest neighbour tours of this thread mark the cities they visit in its own copy
+    LocalSearchTour tour;
+
+    for (int restart = nextRestart++; restart < restarts && !heuristicTimeLimitReached(); restart = nextRestart++)
+    {
+        std::mt19937 generator(programVariables.seed + restart);
+        buildNearestNeighbourTour(tour, std::uniform_int_distribution<int>(0, numberOfCities - 1)(generator), visitTree);
+        offerLocalSearchTour(tour, id); // The starting tour already counts, in case the time limit cuts its improvement short
+
+        tour.dontLook.assign(numberOfCities, false);
+        tour.activeCities.assign(tour.order.begin(), tour.order.end());
+        std::shuffle(tour.activeCities.begin(), tour.activeCities.end(), generator);
+        tour.improvingMoves = 0;
+        bool completed = optimizeTourLocally(tour, candidates, id);
+        programVariables.nodesExpanded += tour.improvingMoves;
+        offerLocalSearchTour(tour, id);
+        if (completed)
+        {
+            std::lock_guard<std::mutex> lock(programVariables.routeMutex);
+            programVariables.restartsCompleted++;
+        }
+    }
+}
+
+/*
+    Cost of the edge between two cities for the Lin-Kernighan engine, whichever storage the adjacencyMatrix uses.
+*/
+int TravelingSalesmanSolver::cityDistance(int from, int to)
+{
+    return programVariables.adjacencyMatrix.distance(from, to);
+}
+
+/*
+    Lists the CANDIDATE_LIST_SIZE nearest cities of every city, nearest first; the list of city c takes entries c * size to (c + 1) * size - 1.
+    The cityTree finds them for coordinate instances (and they are then re-ranked by the instance's distance, which only differs from the 
+    tree's for GEO weights); the costs of each city are sorted otherwise.
+*/
+std::vector<int> TravelingSalesmanSolver::buildCandidateLists(const CityTree &cityTree)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    int size = std::min(CANDIDATE_LIST_SIZE, numberOfCities - 1);
+    std::vector<int> candidates(size_t(numberOfCities) * size);
+    std::vector<int> nearest;
+    std::vector<std::pair<int, int> > ranked;
+
+    for (int city = 0; city < numberOfCities; city++)
+    {
+        ranked.clear();
+        if (!programVariables.cityCoordinates.empty())
+        {
+            cityTree.nearestCities(city, size, nearest);
+            for (size_t i = 0; i < nearest.size(); i++)
+            {
+                ranked.push_back(std::make_pair(cityDistance(city, nearest[i]), nearest[i]));
+            }
+            std::sort(ranked.begin(), ranked.end());
+        }
+        else
+        {
+            for (int other = 0; other < numberOfCities; other++)
+            {
+                if (other != city)
+                {
+                    ranked.push_back(std::make_pair(cityDistance(city, other), other));
+                }
+            }
+            std::partial_sort(ranked.begin(), ranked.begin() + size, ranked.end());
+        }
+        for (int i = 0; i < size; i++)
+        {
+            candidates[size_t(city) * size + i] = ranked[i].second;
+        }
+    }
+
+    return candidates;
+}
+
+/*
+    Builds the nearest neighbour tour starting at city start into tour (order, position and length). The cityTree finds the nearest 
+    unvisited city of a coordinate instance; the costs of the city are scanned otherwise.
+*/
+void TravelingSalesmanSolver::buildNearestNeighbourTour(LocalSearchTour &tour, int start, CityTree &cityTree)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    bool useTree = !programVariables.cityCoordinates.empty();
+    std::vector<bool> visited(useTree ? 0 : numberOfCities, false);
+    if (useTree)
+    {
+        cityTree.resetVisits();
+    }
+    tour.order.clear();
+    tour.order.reserve(numberOfCities);
+    tour.position.assign(numberOfCities, 0);
+    tour.length = 0;
+
+    int city = start;
+    while (true)
+    {
+        tour.position[city] = int(tour.order.size());
+        tour.order.push_back(city);
+        if (int(tour.order.size()) == numberOfCities)
+        {
+            break;
+        }
+
+        int nearest = -1;
+        if (useTree)
+        {
+            cityTree.markVisited(city);
+            nearest = cityTree.nearestUnvisited(city);
+        }
+        else
+        {
+            visited[city] = true;
+            int nearestCost = 0;
+            for (int other = 0; other < numberOfCities; other++)
+            {
+                if (!visited[other])
+                {
+                    int cost = programVariables.adjacencyMatrix.distance(city, other);
+                    if (nearest == -1 || cost < nearestCost)
+                    {
+                        nearest = other;
+                        nearestCost = cost;
+                    }
+                }
+            }
+        }
+        tour.length += cityDistance(city, nearest);
+        city = nearest;
+    }
+    tour.length += cityDistance(city, start);
+}
+
+/*
+    Replaces the edges a-b and c-d of the tour with a-c and b-d, where d is the city after c in the direction from a to b, 
+    so that the move reverses the stretch from b to c. The shorter of that stretch and the rest of the tour (from d to a) is reversed;
+    both give the same tour, only the direction in which order lists it differs.
+*/
+void TravelingSalesmanSolver::applyTwoOptMove(LocalSearchTour &tour, int a, int b, int c)
+{
+    int numberOfCities = int(tour.order.size());
+    bool forward = tour.next(a) == b;
+    int first = forward ? tour.position[b] : tour.position[c];
+    int last = forward ? tour.position[c] : tour.position[b];
+    int length = (last - first + numberOfCities) % numberOfCities + 1;
+    if (2 * length > numberOfCities)
+    {
+        int complementFirst = last + 1 == numberOfCities ? 0 : last + 1;
+        last = first == 0 ? numberOfCities - 1 : first - 1;
+        first = complementFirst;
+        length = numberOfCities - length;
+    }
+
+    for (int i = 0; i < length / 2; i++)
+    {
+        int left = tour.order[first];
+        int right = tour.order[last];
+        tour.order[first] = right;
+        tour.position[right] = first;
+        tour.order[last] = left;
+        tour.position[left] = last;
+        first = first + 1 == numberOfCities ? 0 : first + 1;
+        last = last == 0 ? numberOfCities - 1 : last - 1;
+    }
+}
+
+/*
+    Tries a Lin-Kernighan move starting at city t1, in both directions along the tour. The move removes the edge t1-t2 and chains up to 
+    LIN_KERNIGHAN_MAX_DEPTH 2-opt moves: each adds an edge from the current t2 to one of its candidates t3 (while the cost removed so far 
+    still exceeds the cost added), removes the edge from t3 to its neighbour t4 on the side of t2 and closes the tour with t4-t1, which 
+    the next step removes again with t4 as its t2. The first step tries every such candidate in turn, best first; the later steps only 
+    take the candidate that leaves the most gain to the rest of the chain. A chain is undone back to the step at which the closed tour 
+    was shortest, and kept if that tour beats the one it started from.
+*/
+bool TravelingSalesmanSolver::improveCityWithLinKernighan(LocalSearchTour &tour, int t1, const std::vector<int> &candidates)
+{
+    int size = int(candidates.size() / tour.order.size());
+    int moves[LIN_KERNIGHAN_MAX_DEPTH][4]; // a, b, c, d of each 2-opt move of the chain
+    std::pair<long long, int> firstSteps[CANDIDATE_LIST_SIZE]; // Gain left after each possible first step, and its t3
+
+    for (int direction = 0; direction < 2; direction++)
+    {
+        int firstT2 = direction == 0 ? tour.next(t1) : tour.previous(t1);
+        int numberOfFirstSteps = chooseLinKernighanSteps(tour, t1, firstT2, cityDistance(t1, firstT2), candidates, firstSteps, CANDIDATE_LIST_SIZE);
+
+        for (int alternative = 0; alternative < numberOfFirstSteps; alternative++)
+        {
+            int t2 = firstT2;
+            long long gain = firstSteps[alternative].first; // Cost removed minus cost added so far, leaving out the edge that closes the tour
+            int t3 = firstSteps[alternative].second;
+            long long bestClosedGain = 0;
+            int bestDepth = 0;
+            int depth = 0;
+            while (true)
+            {
+                int t4 = tour.next(t1) == t2 ? tour.previous(t3) : tour.next(t3);
+                long long closedGain = gain - cityDistance(t4, t1);
+                // Reversing a stretch of the tour is what a step costs, so the last step of a chain (when even the nearest candidate of t4
+                // cannot keep the gain positive) is only made if it is kept
+                bool lastStep = depth + 1 == LIN_KERNIGHAN_MAX_DEPTH || cityDistance(t4, candidates[size_t(t4) * size]) >= gain;
+                if (lastStep && closedGain <= bestClosedGain)
+                {
+                    break;
+                }
+                applyTwoOptMove(tour, t1, t2, t4);
+                moves[depth][0] = t1;
+                moves[depth][1] = t2;
+                moves[depth][2] = t4;
+                moves[depth][3] = t3;
+                depth++;
+                t2 = t4;
+                if (closedGain > bestClosedGain)
+                {
+                    bestClosedGain = closedGain;
+                    bestDepth = depth;
+                }
+
+                std::pair<long long, int> nextStep;
+                if (lastStep || chooseLinKernighanSteps(tour, t1, t2, gain, candidates, &nextStep, 1) == 0)
+                {
+                    break;
+                }
+                gain = nextStep.first;
+                t3 = nextStep.second;
+            }
+
+            for (int step = depth - 1; step >= bestDepth; step--) // The tour now has a-c and b-d; the reverse move brings a-b and c-d back
+            {
+                applyTwoOptMove(tour, moves[step][0], moves[step][2], moves[step][1]);
+            }
+            if (bestClosedGain > 0)
+            {
+                tour.length -= bestClosedGain;
+                tour.improvingMoves++;
+                activateCities(tour, &moves[0][0], 4 * bestDepth);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+    Finds the next steps of a Lin-Kernighan move whose last removed edge is t1-t2 and whose gain so far is gain: the candidates t3 of t2 
+    that keep the gain positive, each with the gain left once the edge from t3 to its neighbour t4 is removed. The capacity best steps 
+    are written to steps, best first. Returns their number.
+*/
+int TravelingSalesmanSolver::chooseLinKernighanSteps(const LocalSearchTour &tour, int t1, int t2, long long gain, const std::vector<int> &candidates, 
+    std::pair<long long, int> *steps, int capacity)
+{
+    int numberOfCities = int(tour.order.size());
+    int size = int(candidates.size() / numberOfCities);
+    bool forward = tour.next(t1) == t2;
+    int t2Successor = forward ? tour.next(t2) : tour.previous(t2);
+    const int *list = &candidates[size_t(t2) * size];
+    int numberOfSteps = 0;
+
+    for (int k = 0; k < size; k++)
+    {
+        int t3 = list[k];
+        long long addedCost = cityDistance(t2, t3);
+        if (addedCost >= gain) // The candidates are sorted, so no later one keeps the gain positive either
+        {
+            break;
+        }
+        if (t3 == t1 || t3 == t2Successor)
+        {
+            continue;
+        }
+        int t4 = forward ? tour.previous(t3) : tour.next(t3);
+        std::pair<long long, int> step(gain - addedCost + cityDistance(t3, t4), t3);
+        if (numberOfSteps == capacity && step.first <= steps[capacity - 1].first)
+        {
+            continue;
+        }
+        int at = numberOfSteps < capacity ? numberOfSteps++ : capacity - 1; // Inserted in order; the worst step drops out once steps is full
+        while (at > 0 && steps[at - 1].first < step.first)
+        {
+            steps[at] = steps[at - 1];
+            at--;
+        }
+        steps[at] = step;
+    }
+
+    return numberOfSteps;
+}
+
+/*
+    Tries to move the run of up to OR_OPT_MAX_SEGMENT cities starting at city (in either direction along the tour) between two 
+    neighbouring cities x and y elsewhere, x or y being a candidate of an end of the run, in its own or in reversed order. The first 
+    improving move found is made, as two or three 2-opt moves.
+*/
+bool TravelingSalesmanSolver::improveCityWithOrOpt(LocalSearchTour &tour, int city, const std::vector<int> &candidates)
+{
+    int numberOfCities = int(tour.order.size());
+    int size = int(candidates.size() / numberOfCities);
+
+    for (int direction = 0; direction < 2; direction++)
+    {
+        bool forward = direction == 0;
+        int first = city;
+        int last = city;
+        for (int length = 1; length <= OR_OPT_MAX_SEGMENT && length + 3 <= numberOfCities; length++)
+        {
+            if (length > 1)
+            {
+                last = forward ? tour.next(last) : tour.previous(last);
+            }
+            int before = forward ? tour.previous(first) : tour.next(first);
+            int after = forward ? tour.next(last) : tour.previous(last);
+            long long removalGain = cityDistance(before, first) + cityDistance(last, after) - cityDistance(before, after);
+            if (removalGain <= 0)
+            {
+                continue;
+            }
+
+            for (int end = 0; end < 2; end++)
+            {
+                int endCity = end == 0 ? first : last;
+                const int *list = &candidates[size_t(endCity) * size];
+                for (int k = 0; k < size; k++)
+                {
+                    int c = list[k];
+                    if (cityDistance(endCity, c) >= removalGain) // Sorted candidates: no later one can pay for the new edge either
+                    {
+                        break;
+                    }
+                    int offset = forward ? tour.position[c] - tour.position[first] : tour.position[first] - tour.position[c];
+                    if ((offset + numberOfCities) % numberOfCities < length) // c is inside the run
+                    {
+                        continue;
+                    }
+
+                    for (int side = 0; side < 2; side++) // The run goes between x and y, y following x in the direction of the run
+                    {
+                        int x = side == 0 ? c : forward ? tour.previous(c) : tour.next(c);
+                        int y = side == 0 ? (forward ? tour.next(c) : tour.previous(c)) : c;
+                        if (y == first || x == last)
+                        {
+                            continue;
+                        }
+                        long long edgeCost = cityDistance(x, y);
+                        long long keptOrder = cityDistance(x, first) + cityDistance(last, y) - edgeCost;
+                        long long reversedOrder = cityDistance(x, last) + cityDistance(first, y) - edgeCost;
+                        if (std::min(keptOrder, reversedOrder) >= removalGain)
+                        {
+                            continue;
+                        }
+
+                        applyTwoOptMove(tour, before, first, x); // before x ... after last..first y
+                        applyTwoOptMove(tour, before, x, after); // before after ... x last..first y
+                        if (keptOrder < reversedOrder)
+                        {
+                            applyTwoOptMove(tour, x, last, first); // before after ... x first..last y
+                        }
+                        tour.length -= removalGain - std::min(keptOrder, reversedOrder);
+                        tour.improvingMoves++;
+                        int touched[] = { before, first, last, after, x, y };
+                        activateCities(tour, touched, 6);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+    Clears the don't-look bit of the given cities (the ends of the edges a move changed) and queues the ones that were set.
+*/
+void TravelingSalesmanSolver::activateCities(LocalSearchTour &tour, const int *cities, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (tour.dontLook[cities[i]])
+        {
+            tour.dontLook[cities[i]] = false;
+            tour.activeCities.push_back(cities[i]);
+        }
+    }
+}
+
+/*
+    Improves the tour until no queued city finds a Lin-Kernighan or Or-opt move. A city is taken off the queue with its don't-look bit 
+    set, so it is only tried again once a move touches one of its edges. On large instances this takes a while, so the tour is offered as
+    the best route every ROUTE_REPORT_SECONDS along the way. Returns false if the time limit stopped the improvement first.
+*/
+bool TravelingSalesmanSolver::optimizeTourLocally(LocalSearchTour &tour, const std::vector<int> &candidates, int id)
+{
+    unsigned citiesSinceLimitCheck = 0;
+    std::chrono::steady_clock::time_point lastReport = std::chrono::steady_clock::now();
+
+    while (!tour.activeCities.empty())
+    {
+        if (++citiesSinceLimitCheck == LIMIT_CHECK_INTERVAL)
+        {
+            citiesSinceLimitCheck = 0;
+            if (heuristicTimeLimitReached())
+            {
+                return false;
+            }
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - lastReport).count() >= ROUTE_REPORT_SECONDS)
+            {
+                offerLocalSearchTour(tour, id);
+                lastReport = std::chrono::steady_clock::now();
+            }
+        }
+        int city = tour.activeCities.front();
+        tour.activeCities.pop_front();
+        tour.dontLook[city] = true;
+        if (!improveCityWithLinKernighan(tour, city, candidates))
+        {
+            improveCityWithOrOpt(tour, city, candidates);
+        }
+    }
+
+    return true;
+}
+
+/*
+    Keeps the tour as heuristicRoute if it is shorter than the best one so far, and logs the improvement in routeHistory.
+*/
+void TravelingSalesmanSolver::offerLocalSearchTour(const LocalSearchTour &tour, int id)
+{
+    if (tour.length >= programVariables.bestRouteCost.load())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(programVariables.routeMutex);
+    if (tour.length >= programVariables.bestRouteCost.load())
+    {
+        return;
+    }
+
+    programVariables.bestRouteMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - programVariables.solveStartTime).count();
+    if (programVariables.firstRouteMilliseconds < 0)
+    {
+        programVariables.firstRouteMilliseconds = programVariables.bestRouteMilliseconds;
+    }
+    programVariables.heuristicRoute = tour.order;
+    programVariables.bestRouteCost = double(tour.length);
+    programVariables.routeHistory.push_back(std::make_pair(programVariables.bestRouteMilliseconds, double(tour.length)));
+    addToCounter(programVariables.searchCounters[id]->incumbentUpdates, 1);
+    if (programVariables.logLevel >= LOG_SUMMARY)
+    {
+        std::cout << "Best route so far: " << tour.length << " after " << programVariables.bestRouteMilliseconds << " ms" << std::endl;
+    }
+}
+
+/*
+    Whether the time limit of the Lin-Kernighan engine has passed; sets stoppedByLimit if it has.
+*/
+bool TravelingSalesmanSolver::heuristicTimeLimitReached()
+{
+    if (programVariables.timeLimitSeconds <= 0 
+        || std::chrono::duration<double>(std::chrono::steady_clock::now() - programVariables.solveStartTime).count() < programVariables.timeLimitSeconds)
+    {
+        return false;
+    }
+    programVariables.stoppedByLimit = true;
+    return true;
+}
+
+/*
+    Binomial coefficients: values[n][k] is the number of k-city subsets of n cities. Used to rank subsets within a Held-Karp layer.
+*/
+struct BinomialTable {
+    uint64_t values[MAX_CITIES + 1][MAX_CITIES + 1];
+
+    BinomialTable()
+    {
+        for (int n = 0; n <= MAX_CITIES; n++)
+        {
+            values[n][0] = 1;
+            for (int k = 1; k <= MAX_CITIES; k++)
+            {
+                values[n][k] = n == 0 ? 0 : values[n - 1][k - 1] + values[n - 1][k];
+            }
+        }
+    }
+};
+
+const BinomialTable binomials;
+
+/*
+    Solves the instance with the Held-Karp dynamic program instead of the branch-and-bound search, and records the optimal route as the 
+    foundRoute. The cost of a partial path is stored in the narrowest unsigned type that can hold the longest possible route (16 bits for 
+    most small instances), which halves or quarters the memory traffic of the table compared to int. Instances of up to 
+    SMALL_HELD_KARP_MAX_CITIES cities without negative costs go to the kernel compiled for their number of cities instead.
+*/
+void TravelingSalesmanSolver::heldKarpDispatcher()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    int longestEdge = 0;
+    int shortestEdge = 0;
+    for (int row = 0; row < numberOfCities; row++)
+    {
+        for (int column = 0; column < numberOfCities; column++)
+        {
+            longestEdge = std::max(longestEdge, programVariables.adjacencyMatrix[row][column]);
+            shortestEdge = std::min(shortestEdge, programVariables.adjacencyMatrix[row][column]);
+        }
+    }
+    double longestRoute = double(longestEdge) * numberOfCities;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (shortestEdge >= 0 && numberOfCities <= SMALL_HELD_KARP_MAX_CITIES && longestRoute < double(1 << 24))
+    {
+        dispatchSmallHeldKarp<uint32_t>(); // The cost of a path above a byte for the city it came from
+    }
+    else if (shortestEdge >= 0 && numberOfCities <= SMALL_HELD_KARP_MAX_CITIES)
+    {
+        dispatchSmallHeldKarp<uint64_t>();
+    }
+    else if (shortestEdge >= 0 && longestRoute < std::numeric_limits<uint16_t>::max())
+    {
+        solveWithHeldKarp<uint16_t>();
+    }
+    else if (shortestEdge >= 0 && longestRoute < std::numeric_limits<uint32_t>::max())
+    {
+        solveWithHeldKarp<uint32_t>();
+    }
+    else
+    {
+        solveWithHeldKarp<int64_t>();
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    programVariables.searchMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    programVariables.solveMilliseconds = std::chrono::duration<double, std::milli>(end - programVariables.solveStartTime).count();
+    programVariables.provenLowerBound = programVariables.bestRouteCost.load();
+}
+
+/*
+    Held-Karp: for every subset S of the cities 1..N-1 and every city j in S, the cheapest path that starts at city 0, visits exactly the 
+    cities of S and ends at j is 
+        cost(S, j) = min over i in S - {j} of cost(S - {j}, i) + edge(i, j)         (cost({j}, j) = edge(0, j))
+    and the optimal route closes the cheapest path through all of 1..N-1 back to city 0.
+
+    The table is laid out by layer, a layer holding every subset of one size. Within a layer the subsets are stored in increasing order of 
+    their bitmask (subsetRank() gives a subset's position), and each subset has one entry per member city, in increasing city order. A layer
+    only reads the layer below it, so every layer is split into contiguous ranges of subsets that are filled by separate threads, and only 
+    two layers of costs are kept at a time. The choice of i for each entry is kept in a separate byte-per-entry parent table covering every 
+    layer, which is walked back at the end to recover the route.
+*/
+template <typename Cost>
+void TravelingSalesmanSolver::solveWithHeldKarp()
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    int subsetCities = numberOfCities - 1; // Paths all start at city 0, so subsets are taken over cities 1..N-1; bit c-1 stands for city c
+    std::vector<Cost> distances(numberOfCities * numberOfCities);
+    for (int from = 0; from < numberOfCities; from++)
+    {
+        for (int to = 0; to < numberOfCities; to++)
+        {
+            distances[from * numberOfCities + to] = Cost(programVariables.adjacencyMatrix[from][to]);
+        }
+    }
+
+    std::vector<uint64_t> layerOffset(subsetCities + 2, 0); // Index of the first parent entry of each layer
+    for (int layer = 1; layer <= subsetCities; layer++)
+    {
+        layerOffset[layer + 1] = layerOffset[layer] + binomials.values[subsetCities][layer] * layer;
+    }
+    std::vector<uint8_t> parents(layerOffset[subsetCities + 1]);
+    std::vector<Cost> previousLayer;
+    std::vector<Cost> currentLayer;
+
+    for (int layer = 1; layer <= subsetCities; layer++)
+    {
+        uint64_t subsets = binomials.values[subsetCities][layer];
+        uint64_t workers = std::min<uint64_t>(programVariables.numberOfThreads, (subsets + HELD_KARP_SUBSETS_PER_WORKER - 1) / HELD_KARP_SUBSETS_PER_WORKER);
+        uint8_t *layerParents = parents.data() + layerOffset[layer];
+        currentLayer.resize(subsets * layer);
+
+        std::vector<std::thread> threads;
+        for (uint64_t worker = 1; worker < workers; worker++)
+        {
+            threads.push_back(std::thread(&TravelingSalesmanSolver::fillHeldKarpLayer<Cost>, this, layer, subsets * worker / workers, subsets * (worker + 1) / workers, 
+                std::cref(distances), std::cref(previousLayer), std::ref(currentLayer), layerParents));
+        }
+        fillHeldKarpLayer<Cost>(layer, 0, subsets / workers, distances, previousLayer, currentLayer, layerParents);
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+
+        programVariables.nodesExpanded += subsets * layer;
+        previousLayer.swap(currentLayer);
+    }
+
+    // The last layer holds the single subset of every city; close each of its paths back to city 0
+    RowMask everyCity = (RowMask(1) << subsetCities) - 1;
+    int lastCity = 0;
+    int64_t bestCost = std::numeric_limits<int64_t>::max();
+    int position = 0;
+    for (RowMask members = everyCity; members != 0; members &= members - 1, position++)
+    {
+        int city = __builtin_ctzll(members) + 1;
+        int64_t cost = int64_t(previousLayer[position]) + distances[city * numberOfCities];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            lastCity = city;
+        }
+    }
+
+    // Walk the parent table back from the last city of the route to city 0
+    std::pair<int, int> edges[MAX_CITIES];
+    edges[0] = std::make_pair(lastCity, 0);
+    RowMask subset = everyCity;
+    int city = lastCity;
+    for (int layer = subsetCities; layer >= 1; layer--)
+    {
+        RowMask cityBit = RowMask(1) << (city - 1);
+        int parent = parents[layerOffset[layer] + subsetRank(subset) * layer + __builtin_popcountll(subset & (cityBit - 1))];
+        edges[subsetCities - layer + 1] = std::make_pair(parent, city);
+        subset &= ~cityBit;
+        city = parent;
+    }
+
+    node route = createRouteNode(edges, 0);
+    updateFoundRoute(route, 0);
+}
+
+/*
+    Runs the solveWithSmallHeldKarp() kernel instantiated for the instance's number of cities (3 to SMALL_HELD_KARP_MAX_CITIES).
+*/
+template <typename Entry>
+void TravelingSalesmanSolver::dispatchSmallHeldKarp()
+{
+    switch (programVariables.numberOfCitiesToVisit)
+    {
+        case 3: solveWithSmallHeldKarp<Entry, 3>(); break;
+        case 4: solveWithSmallHeldKarp<Entry, 4>(); break;
+        case 5: solveWithSmallHeldKarp<Entry, 5>(); break;
+        case 6: solveWithSmallHeldKarp<Entry, 6>(); break;
+        case 7: solveWithSmallHeldKarp<Entry, 7>(); break;
+        case 8: solveWithSmallHeldKarp<Entry, 8>(); break;
+        case 9: solveWithSmallHeldKarp<Entry, 9>(); break;
+        case 10: solveWithSmallHeldKarp<Entry, 10>(); break;
+        case 11: solveWithSmallHeldKarp<Entry, 11>(); break;
+        case 12: solveWithSmallHeldKarp<Entry, 12>(); break;
+        case 13: solveWithSmallHeldKarp<Entry, 13>(); break;
+        case 14: solveWithSmallHeldKarp<Entry, 14>(); break;
+        case 15: solveWithSmallHeldKarp<Entry, 15>(); break;
+        case 16: solveWithSmallHeldKarp<Entry, 16>(); break;
+    }
+}
+
+/*
+    The Held-Karp dynamic program of solveWithHeldKarp() for an instance of exactly N cities, in std::array tables whose sizes are fixed when 
+    it is compiled. A subset of cities 1..N-1 is indexed by its bitmask rather than by its rank in a layer, with N - 1 entries (only those 
+    of its members are used), and the subsets are filled in increasing bitmask order, which reaches each one after the smaller subsets it 
+    is built from. Each entry packs the cost of the path above its low byte and the city the path came from in the low byte, so choosing 
+    that city is a branch-free minimum instead of a compare-and-branch per member. Against the general version this saves the ranking, the
+    separate parent table, the per-layer allocations and the thread start-up, which dominate on small instances. Entry must leave 8 bits 
+    below the longest route.
+*/
+template <typename Entry, int N>
+void TravelingSalesmanSolver::solveWithSmallHeldKarp()
+{
+    const int CITIES = N - 1; // Bit c-1 of a subset stands for city c
+    const int SUBSETS = 1 << CITIES;
+    const Entry PARENT_BITS = 0xFF;
+    const Entry UNREACHABLE = std::numeric_limits<Entry>::max();
+    struct Tables {
+        std::array<Entry, CITIES * CITIES> steps; // steps[j * CITIES + i]: the cost of the edge between cities i + 1 and j + 1, packed with city i + 1
+        std::array<Entry, SUBSETS * CITIES> entries; // entries[subset * CITIES + j]: the cheapest path over subset ending at city j + 1, packed with its parent
+    };
+    std::unique_ptr<Tables> tables(new Tables); // Up to 2 MB for 16 cities, too much for the stack of a batch thread
+    std::array<Entry, CITIES * CITIES> &steps = tables->steps;
+    std::array<Entry, SUBSETS * CITIES> &entries = tables->entries;
+    for (int j = 0; j < CITIES; j++)
+    {
+        for (int i = 0; i < CITIES; i++)
+        {
+            steps[j * CITIES + i] = (Entry(programVariables.adjacencyMatrix[i + 1][j + 1]) << 8) | Entry(i + 1);
+        }
+    }
+
+    for (int subset = 1; subset < SUBSETS; subset++)
+    {
+        Entry *current = &entries[subset * CITIES];
+        for (int members = subset; members != 0; members &= members - 1)
+        {
+            int j = __builtin_ctz(members);
+            int cityBit = 1 << j;
+            if (subset == cityBit)
+            {
+                current[j] = Entry(programVariables.adjacencyMatrix[0][j + 1]) << 8; // Came from city 0
+                continue;
+            }
+
+            int others = subset & ~cityBit;
+            const Entry *previous = &entries[others * CITIES];
+            const Entry *step = &steps[j * CITIES];
+            Entry best = UNREACHABLE;
+            for (; others != 0; others &= others - 1)
+            {
+                int i = __builtin_ctz(others);
+                best = std::min(best, Entry((previous[i] & ~PARENT_BITS) + step[i]));
+            }
+            current[j] = best;
+        }
+    }
+    programVariables.nodesExpanded += uint64_t(CITIES) << (CITIES - 1); // The entries of the members of every subset, as counted by solveWithHeldKarp()
+
+    // Close each path through every city back to city 0, then walk the parents back from the last city
+    int everyCity = SUBSETS - 1;
+    int lastCity = 0;
+    int64_t bestCost = std::numeric_limits<int64_t>::max();
+    for (int j = 0; j < CITIES; j++)
+    {
+        int64_t cost = int64_t(entries[everyCity * CITIES + j] >> 8) + programVariables.adjacencyMatrix[j + 1][0];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            lastCity = j + 1;
+        }
+    }
+
+    std::pair<int, int> edges[N];
+    edges[0] = std::make_pair(lastCity, 0);
+    int subset = everyCity;
+    int city = lastCity;
+    for (int step = 1; step <= CITIES; step++)
+    {
+        int parent = int(entries[subset * CITIES + city - 1] & PARENT_BITS);
+        edges[step] = std::make_pair(parent, city);
+        subset &= ~(1 << (city - 1));
+        city = parent;
+    }
+
+    node route = createRouteNode(edges, 0);
+    updateFoundRoute(route, 0);
+}
+
+/*
+    Fills the entries of the subsets ranked firstRank up to (not including) lastRank in one Held-Karp layer (see solveWithHeldKarp()). The
+    first subset is found with subsetOfRank(); the following ones are the next larger bitmasks with the same number of bits.
+*/
+template <typename Cost>
+void TravelingSalesmanSolver::fillHeldKarpLayer(int layer, uint64_t firstRank, uint64_t lastRank, const std::vector<Cost> &distances, 
+    const std::vector<Cost> &previousLayer, std::vector<Cost> &currentLayer, uint8_t *parents)
+{
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    if (firstRank >= lastRank)
+    {
+        return;
+    }
+
+    uint64_t othersRank[MAX_CITIES]; // Rank of the subset without its i-th member, in the layer below
+    RowMask subset = subsetOfRank(firstRank, layer);
+    for (uint64_t rank = firstRank; rank < lastRank; rank++)
+    {
+        // Dropping the i-th member moves every member above it down one place, so each of those contributes binomial(bit, place - 1) instead
+        uint64_t below = 0;
+        int place = 1;
+        for (RowMask members = subset; members != 0; members &= members - 1, place++)
+        {
+            othersRank[place - 1] = below;
+            below += binomials.values[__builtin_ctzll(members)][place];
+        }
+        uint64_t above = 0;
+        place = layer;
+        for (RowMask members = subset; members != 0; members &= ~(RowMask(1) << (63 - __builtin_clzll(members))), place--)
+        {
+            othersRank[place - 1] += above;
+            above += binomials.values[63 - __builtin_clzll(members)][place - 1];
+        }
+
+        uint64_t entry = rank * layer;
+        place = 0;
+        for (RowMask members = subset; members != 0; members &= members - 1, entry++, place++)
+        {
+            int city = __builtin_ctzll(members) + 1;
+            const Cost *costsToCity = &distances[city * numberOfCities]; // The matrix is symmetric, so row city holds the cost of reaching city from each city
+            if (layer == 1)
+            {
+                currentLayer[entry] = costsToCity[0];
+                parents[entry] = 0;
+                continue;
+            }
+
+            RowMask others = subset & ~(RowMask(1) << (city - 1));
+            const Cost *previous = &previousLayer[othersRank[place] * (layer - 1)]; // One entry per city of others, in the order the loop visits them
+            Cost best = std::numeric_limits<Cost>::max();
+            int bestParent = 0;
+            for (; others != 0; others &= others - 1, previous++)
+            {
+                int from = __builtin_ctzll(others) + 1;
+                Cost cost = Cost(*previous + costsToCity[from]);
+                if (cost < best)
+                {
+                    best = cost;
+                    bestParent = from;
+                }
+            }
+            currentLayer[entry] = best;
+            parents[entry] = uint8_t(bestParent);
+        }
+
+        // Next larger bitmask with the same number of bits (Gosper's hack), which is the subset of the next rank
+        RowMask lowestBit = subset & (~subset + 1);
+        RowMask ripple = subset + lowestBit;
+        subset = (((ripple ^ subset) >> 2) / lowestBit) | ripple;
+    }
+}
+
+/*
+    Position of a subset among all subsets of the same size, ordered by bitmask: the sum over its members of binomial(bit, i), where bit is 
+    the i-th lowest set bit (counting from 1).
+*/
+uint64_t subsetRank(RowMask subset)
+{
+    uint64_t rank = 0;
+    for (int i = 1; subset != 0; subset &= subset - 1, i++)
+    {
+        rank += binomials.values[__builtin_ctzll(subset)][i];
+    }
+    return rank;
+}
+
+/*
+    Inverse of subsetRank(): the subset of the given size at the given position. Members are picked from the highest bit down, each time 
+    taking the highest bit whose binomial still fits in what is left of the rank.
+*/
+RowMask subsetOfRank(uint64_t rank, int size)
+{
+    RowMask subset = 0;
+    int bit = MAX_CITIES - 1;
+    for (int i = size; i >= 1; i--, bit--)
+    {
+        while (binomials.values[bit][i] > rank)
+        {
+            bit--;
+        }
+        subset |= RowMask(1) << bit;
+        rank -= binomials.values[bit][i];
+    }
+    return subset;
+}
+
+/*
+    Once a route is found, this method terminates the nodes at the top of a worker's queue that have a lowerbound no better than the best route.
+    It is called with the queue's mutex held, each time a node is about to be taken from the queue.
+
+    Children that cannot beat the best route are never queued (see checkInclude()), but a better route makes some of the nodes already queued 
+    useless, wherever they sit in the heap. Those below the top are left where they are (lazy deletion) until the route has improved by 
+    QUEUE_COMPACTION_IMPROVEMENT since the queue was last compacted; then, if the queue holds at least QUEUE_COMPACTION_MIN_NODES nodes, 
+    all of them are dropped at once and the heap rebuilt (see NodeQueue::removeBoundedBy()).
+*/
+void TravelingSalesmanSolver::pruneNodesUpdated(WorkerQueue &workerQueue, int id)
+{
+    double bestRouteCost = programVariables.bestRouteCost.load();
+    double compactedAtCost = workerQueue.compactedAtCost;
+    bool improved = bestRouteCost < compactedAtCost && (compactedAtCost == std::numeric_limits<double>::infinity() 
+        || bestRouteCost < compactedAtCost - std::fabs(compactedAtCost) * QUEUE_COMPACTION_IMPROVEMENT); // Relative to the cost's size, not its sign
+    if (workerQueue.unprocessedNodesQueue.size() >= QUEUE_COMPACTION_MIN_NODES && improved)
+    {
+        size_t removed = workerQueue.unprocessedNodesQueue.removeBoundedBy(bestRouteCost, [this, id](const node &unprocessedNode)
+        {
+            if (programVariables.logLevel == LOG_TRACE)
+            {
+                programVariables.traceLog.record(id, TRACE_PRUNED, unprocessedNode);
+            }
+            programVariables.nodeArena.release(unprocessedNode.configurationSlot, id);
+        });
+        programVariables.outstandingNodes -= int(removed);
+        workerQueue.compactedAtCost = bestRouteCost;
+        addToCounter(programVariables.searchCounters[id]->prunedByCompaction, removed);
+        addToCounter(programVariables.searchCounters[id]->queueCompactions, 1);
+    }
+
+    while (!workerQueue.unprocessedNodesQueue.empty())
+    {
+        const node &unprocessedNode = workerQueue.unprocessedNodesQueue.top(); // Each call to top() will be the node with the lowest lowerBound
+
+        if (unprocessedNode.lowerBound >= programVariables.bestRouteCost.load())
+        {
+            if (programVariables.logLevel == LOG_TRACE)
+            {
+                programVariables.traceLog.record(id, TRACE_PRUNED, unprocessedNode);
+            }
+            programVariables.nodeArena.release(unprocessedNode.configurationSlot, id);
+            workerQueue.unprocessedNodesQueue.pop();
+            programVariables.outstandingNodes--;
+            addToCounter(programVariables.searchCounters[id]->prunedAtPop, 1);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+/*
+    Prints the configurationMatrix for a node to the console.
+*/
+void TravelingSalesmanSolver::print(const node &nodeX)
+{
+    std::cout << "Lowerbound : " << nodeX.lowerBound << std::endl;
+    std::cout << "Configuration Matrix: " << std::endl << std::endl;
+
+
+    // For each column, the number of the city is printed
+    for(int i = 0; i < programVariables.numberOfCitiesToVisit; i++)
+    {
+        std::cout << std::setw(2) << i << " ";
+    }
+
+    std::cout << "#1" << " " << "~#1" << std::endl; 
+    
+    
+    // Prints the values for each cell in the configurationMatrix, expanding the bitmasks back into '1', '-1' and '0' cells
+    Configuration configuration = configurationOf(nodeX);
+    for (int row = 0; row < programVariables.numberOfCitiesToVisit; row++)
+    {
+        for (int column = 0; column < programVariables.numberOfCitiesToVisit; column++)
+        {
+            int cell = 0;
+            if (configuration.includedEdges[row] & (RowMask(1) << column))
+            {
+                cell = 1;
+            }
+            else if (configuration.excludedEdges[row] & (RowMask(1) << column))
+            {
+                cell = -1;
+            }
+            std::cout << std::setw(2) << cell << " ";
+        }
+        std::cout << std::setw(2) << int(configuration.includeColumn[row]) << " " << std::setw(2) << int(configuration.excludeColumn[row]) << " ";
+        std::cout << std::endl;
+    }
+    
+    std::cout << std::endl;
+    std::cout << "Constraint: " << "<" << nodeX.constraint.first << "><" << nodeX.constraint.second << ">" << std::endl << std::endl;
+    
+}
+
+/*
+    Returns the best route found, city by city from city 0 and back to it; empty if no route was found.
+*/
+std::vector<int> TravelingSalesmanSolver::bestRoute()
+{
+    std::vector<int> route;
+    if (programVariables.bestRouteCost.load() == std::numeric_limits<double>::infinity())
+    {
+        return route;
+    }
+    if (programVariables.engineUsed == LIN_KERNIGHAN_ENGINE) // The tour is kept in order; it is rotated to start from city 0 like the others
+    {
+        const std::vector<int> &tour = programVariables.heuristicRoute;
+        size_t start = std::find(tour.begin(), tour.end(), 0) - tour.begin();
+        route.insert(route.end(), tour.begin() + start, tour.end());
+        route.insert(route.end(), tour.begin(), tour.begin() + start);
+        route.push_back(0);
+        return route;
+    }
+
+    int numberOfCities = programVariables.numberOfCitiesToVisit;
+    Configuration configuration = configurationOf(programVariables.foundRoute);
+    RowMask visited = 0;
+    int currentCity = 0; // Start from city 0
+
+    // While loop makes sure each city is only visited once
+    while (int(route.size()) < numberOfCities) {
+        route.push_back(currentCity);
+        visited |= RowMask(1) << currentCity;
+
+        RowMask unvisitedNeighbours = configuration.includedEdges[currentCity] & ~visited; // Included edges leading to cities we have yet to visit
+        if (unvisitedNeighbours == 0)
+        {
+            break;
+        }
+        currentCity = __builtin_ctzll(unvisitedNeighbours);
+    }
+
+    // Return to the starting city
+    route.push_back(0);
+    return route;
+}
+
+/*
+    This method will begin at the starting city 0, and print the lowest cost route city by city
+*/
+void TravelingSalesmanSolver::printBestRoute()
+{
+    std::vector<int> route = bestRoute();
+
+    // Print the route
+    for (size_t i = 0; i + 1 < route.size(); i++) {
+        std::cout << route[i] << " -> ";
+    }
+    std::cout << route.back() << std::endl;
+}
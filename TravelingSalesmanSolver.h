@@ -0,0 +1,714 @@
+/*
+    Branch-and-bound solver shared by the command line program (TravelingSalesmanParallel.cpp) and the benchmark (TravelingSalesmanBenchmark.cpp).
+    An instance is put into the programVariables of a TravelingSalesmanSolver (adjacencyMatrix, or cityCoordinates and edgeWeightType, plus 
+    numberOfCitiesToVisit) and solved with solveLoadedInstance().
+*/
+#ifndef TRAVELING_SALESMAN_SOLVER_H
+#define TRAVELING_SALESMAN_SOLVER_H
+
+#include <iostream>
+#include <queue>
+#include <deque>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+
+typedef uint64_t RowMask; // One bit per city; bit j of row i stands for the edge i <-> j
+const int MAX_CITIES = 64; // Width of a RowMask
+const int MAX_INSTANCE_CITIES = 1 << 20; // Largest number of cities an instance file may declare; above MAX_CITIES only for the Lin-Kernighan engine
+const int UNUSABLE_EDGE = std::numeric_limits<int>::max(); // Row bound of a city that can no longer be given two edges
+
+// Lower bound computed for every node; chosen on the command line with "--bound simple" or "--bound onetree"
+enum BoundType { SIMPLE_BOUND, ONE_TREE_BOUND };
+const int ROOT_SUBGRADIENT_ITERATIONS = 100; // Held-Karp iterations at the root, starting from zero penalties
+const int CHILD_SUBGRADIENT_ITERATIONS = 10; // Held-Karp iterations at a child, warm-started from its parent's penalties
+const int NEIGHBOUR_LIST_SIZE = 8; // Candidate cities tried by the 2-opt and Or-opt moves of the starting route heuristic
+
+// Method used to solve an instance; chosen on the command line with "--engine auto|bnb|dp|lk". Only lk handles more than MAX_CITIES cities, 
+// and its routes are not proven optimal.
+enum SolverEngine { AUTO_ENGINE, BRANCH_AND_BOUND_ENGINE, HELD_KARP_ENGINE, LIN_KERNIGHAN_ENGINE };
+const char *const ENGINE_NAMES[] = { "auto", "bnb", "dp", "lk" };
+const int AUTO_HELD_KARP_MAX_CITIES = 24; // Largest instance the automatic choice hands to the Held-Karp engine
+const int HELD_KARP_MAX_CITIES = 28; // Largest instance the Held-Karp engine accepts; its parent table takes (N-1) * 2^(N-2) bytes
+const uint64_t HELD_KARP_SUBSETS_PER_WORKER = 4096; // Smallest share of a Held-Karp layer worth starting a thread for
+const int SMALL_HELD_KARP_MAX_CITIES = 16; // Largest instance solved by a Held-Karp kernel compiled for its exact number of cities
+const int CANDIDATE_LIST_SIZE = 10; // Nearest cities the moves of the Lin-Kernighan engine try to connect each city to
+const int LIN_KERNIGHAN_MAX_DEPTH = 6; // Most 2-opt moves chained into one Lin-Kernighan move
+const int OR_OPT_MAX_SEGMENT = 3; // Longest run of cities an Or-opt move of the Lin-Kernighan engine relocates
+const int CITY_TREE_LEAF_SIZE = 8; // Most cities in a leaf of the CityTree
+const double ROUTE_REPORT_SECONDS = 1.0; // Interval at which the Lin-Kernighan engine offers the tour it is still improving as the best route
+
+// Order in which the branch-and-bound engine expands nodes; chosen on the command line with "--search bestfirst|dfs|hybrid"
+enum SearchMode { BEST_FIRST_SEARCH, DEPTH_FIRST_SEARCH, HYBRID_SEARCH };
+const int DEPTH_FIRST_SUBTREES_PER_WORKER = 4; // With --search dfs, queued nodes per worker from which popped nodes are searched depth-first
+const long long DEFAULT_MEMORY_BUDGET_MB = 1024; // With --search hybrid, size of the queues from which popped nodes are searched depth-first
+// How a popped node is turned into queued children; chosen on the command line with "--expansion edge|row"
+enum ExpansionMode { EDGE_EXPANSION, ROW_EXPANSION };
+const char *const EXPANSION_MODE_NAMES[] = { "edge", "row" };
+const int DOMINANCE_CACHE_WAYS = 4; // Entries per bucket of the DominanceCache; four 16-byte entries fill a cache line
+const int DOMINANCE_CACHE_LOCKS = 1024; // Mutexes of the DominanceCache; bucket b is guarded by mutex b % DOMINANCE_CACHE_LOCKS
+// How the branch-and-bound engine picks the edge a node branches on; chosen on the command line with "--branching rowmajor|constrained|penalty|strong"
+enum BranchingStrategy { ROW_MAJOR_BRANCHING, CONSTRAINED_CITY_BRANCHING, EXCLUSION_PENALTY_BRANCHING, STRONG_BRANCHING };
+const char *const BRANCHING_STRATEGY_NAMES[] = { "rowmajor", "constrained", "penalty", "strong" };
+const int NUMBER_OF_BRANCHING_STRATEGIES = 4;
+const int STRONG_BRANCHING_CANDIDATES = 4; // Edges whose two children are bounded by the strong branching strategy before one is chosen
+const size_t QUEUE_COMPACTION_MIN_NODES = 1024; // Smallest worker queue that is compacted in bulk when the best route improves (see pruneNodesUpdated())
+const double QUEUE_COMPACTION_IMPROVEMENT = 0.02; // Fraction by which the best route must improve since a queue's last compaction before it is compacted again
+const unsigned LIMIT_CHECK_INTERVAL = 256; // Nodes a worker takes up between two checks of the time and node limits (see searchLimitReached())
+const double DEFAULT_CHECKPOINT_SECONDS = 60; // Interval between two checkpoints of the search (--checkpoint-interval)
+const int DISTRIBUTED_NODES_PER_WORKER = 16; // Open nodes per worker process the coordinator of a distributed search makes before handing them out
+const int MAX_STOLEN_NODES = 256; // Most nodes a worker process gives up when the coordinator asks it for some
+const int STEAL_RETRY_MILLISECONDS = 10; // How often the coordinator asks busy workers for nodes again while some worker is idle
+const int CONNECT_RETRY_SECONDS = 10; // How long a worker process keeps trying to reach the coordinator
+
+/*
+    A node encapsulates a "route" in expansion. The node itself is small, so it is cheap to move into and out of the queues; the configurationMatrix 
+    it describes lives in a block of the NodeArena (see Configuration below), referenced by configurationSlot.
+*/
+struct node{
+    double lowerBound; // Smallest cost of all edges in the route; sums the cost of the current included edges with the least cost edges 
+    std::pair<int, int> constraint; // Indexes a cell (edge) that will be examined for possible inclusion/exclusion
+    bool include; // Set to true if the constraint cell can be included
+    bool exclude; // Set to true if the constraint cell can be excluded
+    uint8_t includedEdgeCount; // Number of edges included so far; the route is complete when it reaches numberOfCitiesToVisit
+    uint32_t configurationSlot; // Index of the arena block holding this node's configurationMatrix
+};
+
+/*
+    What modifyMatrix() changed beyond the constraint's cell, so that undoModifyMatrix() can take it back and the bound can be updated for 
+    exactly the rows that changed.
+*/
+struct MatrixChange {
+    int fragmentEnds[2]; // Before an include: the far ends of the fragments of constraint.first and constraint.second
+    std::pair<int, int> forbiddenEdge; // Edge excluded because it would have closed the new fragment into a subtour; (-1, -1) if none
+    int rows[4]; // Rows whose cells changed: the constraint's two, plus those of forbiddenEdge
+    int numberOfRows;
+};
+
+/*
+    One level of a depth-first search (see searchDepthFirst()). parent is the node of this level once its constraint has been advanced and 
+    its flags set. The change made for the current child and the bound cache of the rows it touched are saved so that it can be undone.
+*/
+struct DepthFirstFrame {
+    node parent;
+    MatrixChange change;
+    int rowLowerBound[4]; // Bounds of change.rows before the change
+    int lowerBoundTotal;
+    uint8_t nextChild; // 0: the include child is next, 1: the exclude child is next, 2: both are done
+    uint8_t appliedChild; // Child whose edge is currently applied to the matrix: 0 none, 1 include, 2 exclude
+};
+
+// An edge a node could branch on, scored by how much excluding it would raise the simple bound (see scoreExclusionPenalties())
+struct BranchingCandidate {
+    int first;
+    int second;
+    long long penalty; // UNUSABLE_EDGE or more if excluding the edge leaves a city unable to get two edges
+    int cost;
+};
+
+// The levels of a worker's depth-first search, plus the 1-tree penalties of each level (numberOfCitiesToVisit per level) with that bound
+struct DepthFirstStack {
+    std::vector<DepthFirstFrame> frames;
+    std::vector<double> penalties;
+};
+
+/*
+    The configurationMatrix of a node, as stored in its arena block. Row i of the N x N part of the matrix is split into two bitmasks: 
+    includedEdges[i] has bit j set where the old matrix held '1', and excludedEdges[i] has bit j set where it held '-1'. The two extra
+    columns are kept as bytes: includeColumn[i] is the number of edges included in row i, and excludeColumn[i] is the number of edges 
+    in row i that can still be included or excluded.
+
+    rowLowerBound[i] caches the cost of the two cheapest edges city i can still use, and lowerBoundTotal is the sum of the row bounds, so that
+    a child's bound can be updated by rescanning only the rows its change touches.
+
+    The included edges form paths ("fragments"). fragmentEnd[i] is the city at the other end of the fragment that ends at city i (i itself 
+    for a city with no included edge). It is only kept up to date for cities at the end of a fragment, which are the only ones that can 
+    still be given an edge.
+
+    penalties holds the Held-Karp city penalties of the 1-tree bound. It is only part of the block when that bound is selected (null otherwise).
+*/
+struct Configuration {
+    RowMask *includedEdges;
+    RowMask *excludedEdges;
+    double *penalties;
+    int *rowLowerBound;
+    int *lowerBoundTotal;
+    uint8_t *includeColumn;
+    uint8_t *excludeColumn;
+    uint8_t *fragmentEnd;
+};
+
+/*
+    Pool of fixed-size blocks holding the configurationMatrix of every live node. Blocks are carved out of large chunks that are never moved
+    or freed during a search, and released blocks are recycled through free lists: each worker keeps a small cache of free slots and only 
+    takes the arena mutex to move a batch of slots between its cache and the shared free list. Once the arena has warmed up, expanding a 
+    node does not touch the heap.
+*/
+class NodeArena {
+public:
+    NodeArena() : blockBytes(0), nextSlot(0) {}
+    void reset(int bytesPerBlock, int numberOfWorkers);
+    uint32_t allocate(int id);
+    void release(uint32_t slot, int id);
+    unsigned char *block(uint32_t slot) const { return chunks[slot / BLOCKS_PER_CHUNK].get() + (size_t)(slot % BLOCKS_PER_CHUNK) * blockBytes; }
+    int bytesPerBlock() const { return blockBytes; }
+
+private:
+    static const uint32_t BLOCKS_PER_CHUNK = 16384;
+    static const uint32_t MAX_CHUNKS = 4096;
+    static const size_t SLOT_BATCH = 64; // Number of slots moved between a worker's cache and the shared free list at a time
+
+    int blockBytes;
+    std::mutex arenaMutex; // Guards nextSlot, sharedFreeSlots and the creation of chunks
+    uint32_t nextSlot; // First slot that has never been handed out
+    std::unique_ptr<unsigned char[]> chunks[MAX_CHUNKS];
+    std::vector<uint32_t> sharedFreeSlots;
+    std::vector<std::vector<uint32_t> > workerFreeSlots; // Per-worker caches, each only touched by its own worker
+};
+
+/*
+    k-d tree over the city coordinates of a coordinate instance. The Lin-Kernighan engine uses it to find the nearest cities of every city 
+    and to build nearest neighbour tours without computing all N x N distances. The tree measures plain Euclidean distances between the 
+    raw coordinates, so callers re-rank what it returns with the instance's own distance. Each node counts the cities below it that a 
+    nearest neighbour tour has not visited yet, so that finished subtrees are skipped; a copy of the tree is made for each tour built.
+*/
+class CityTree {
+public:
+    void build(const std::vector<std::pair<double, double> > &coordinates);
+    void nearestCities(int city, int count, std::vector<int> &nearest) const;
+    void resetVisits();
+    void markVisited(int city);
+    int nearestUnvisited(int city) const;
+
+private:
+    struct TreeNode {
+        int first, last; // Range of cities (in the cities array) below this node
+        int left, right; // Children; -1 for a leaf
+        int parent;
+        double minX, maxX, minY, maxY; // Bounding box of the cities below this node
+        int unvisited; // Cities below this node not visited yet
+    };
+
+    int buildNode(int first, int last, int parent);
+    double boxDistance(const TreeNode &treeNode, const std::pair<double, double> &point) const;
+
+    std::vector<std::pair<double, double> > points;
+    std::vector<int> cities; // City numbers, ordered so that each node's cities are contiguous
+    std::vector<TreeNode> nodes; // nodes[0] is the root
+    std::vector<int> leafOf; // Leaf holding each city
+    std::vector<bool> visited;
+};
+
+/*
+    Tour being improved by the Lin-Kernighan engine: the cities in tour order and the position of each city in it, so that the neighbours
+    of a city are found in constant time and a 2-opt move reverses one stretch of the order. A city whose don't-look bit is set is not tried 
+    again until a move changes one of its edges; the cities whose bit is off wait in activeCities.
+*/
+struct LocalSearchTour {
+    std::vector<int> order;
+    std::vector<int> position;
+    std::vector<bool> dontLook;
+    std::deque<int> activeCities;
+    long long length;
+    long long improvingMoves;
+
+    int next(int city) const { int at = position[city] + 1; return order[at == int(order.size()) ? 0 : at]; }
+    int previous(int city) const { int at = position[city]; return order[(at == 0 ? int(order.size()) : at) - 1]; }
+};
+
+// How much the solver reports; chosen on the command line with "--log silent|summary|trace"
+enum LogLevel { LOG_SILENT, LOG_SUMMARY, LOG_TRACE };
+
+// Events a worker can record in trace mode
+enum TraceEvent { TRACE_INCLUDED, TRACE_EXCLUDED, TRACE_CANNOT_INCLUDE, TRACE_CANNOT_EXCLUDE, TRACE_PRUNED, TRACE_ROUTE_FOUND };
+
+// One trace entry. Records are copied as-is into a ring buffer; turning them into text is left to the drain thread.
+struct TraceRecord {
+    uint64_t nanoseconds; // Time since the trace started
+    double lowerBound;
+    uint16_t worker;
+    uint8_t event; // TraceEvent
+    uint8_t row; // Constraint of the node the event is about
+    uint8_t column;
+};
+
+/*
+    Per-node trace of the search. Each worker appends fixed-size records to its own ring buffer (a single-producer, single-consumer queue, 
+    so no lock is needed), and a background thread drains the rings and writes them to the trace file. A worker only waits if its ring is 
+    full, which means the drain thread is behind.
+
+    Nothing is recorded unless the log level is LOG_TRACE; callers check the level before building a record.
+*/
+class TraceLog {
+public:
+    TraceLog() : file(NULL), stopDraining(false) {}
+    bool start(const std::string &path, int numberOfWorkers);
+    void stop();
+    void record(int id, TraceEvent event, const node &nodeX);
+
+private:
+    static const uint64_t RING_CAPACITY = 8192; // Records per worker; a power of two
+
+    struct Ring {
+        std::atomic<uint64_t> written; // Records appended by the worker
+        char padding[64 - sizeof(std::atomic<uint64_t>)]; // Keeps the worker's and the drain thread's counters on separate cache lines
+        std::atomic<uint64_t> drained; // Records written out by the drain thread
+        TraceRecord records[RING_CAPACITY];
+
+        Ring() : written(0), drained(0) {}
+    };
+
+    void drainLoop();
+    bool drainRings();
+
+    FILE *file;
+    std::vector<std::unique_ptr<Ring> > rings;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<bool> stopDraining;
+    std::thread drainThread;
+};
+
+/*
+    Adds to a counter that only one thread writes. A relaxed load and store is as cheap as a plain increment (no locked instruction), and 
+    other threads can still read the counter while it changes.
+*/
+inline void addToCounter(std::atomic<long long> &counter, long long amount)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/*
+    Statistics of one worker, written only by that worker (see addToCounter()) and read by the progress line and the statistics report while 
+    the search runs. The padding keeps two workers' counters off each other's cache lines.
+
+    The phase times are only measured when timeSearchPhases is on, as reading the clock around every bound and queue operation is not free.
+*/
+struct SearchCounters {
+    std::atomic<long long> nodesCreated; // Nodes given a bound: the root and every include/exclude child
+    std::atomic<long long> nodesExpanded; // Nodes whose children were made
+    std::atomic<long long> prunedAtPush; // Children dropped instead of queued
+    std::atomic<long long> prunedAtPop; // Nodes dropped when taken up because their bound cannot beat the best route
+    std::atomic<long long> prunedByCompaction; // Queued nodes dropped by a compaction of a queue after the best route improved
+    std::atomic<long long> queueCompactions;
+    std::atomic<long long> incumbentUpdates; // Routes that became the best route
+    std::atomic<long long> dominanceHits; // Nodes dropped because the DominanceCache held a cheaper node with the same signature
+    std::atomic<long long> dominanceMisses; // Nodes looked up in the DominanceCache and recorded there
+    std::atomic<long long> dominanceEvictions; // Entries of the DominanceCache overwritten by a node with another signature
+    std::atomic<long long> boundNanoseconds; // Computing the lower bound of children
+    std::atomic<long long> cycleCheckNanoseconds; // checkForCycles()
+    std::atomic<long long> queueNanoseconds; // Pushing, popping (stealing and pruning included) queued nodes
+    std::atomic<double> expandingBound; // Bound of the node the worker is expanding or searching depth-first; infinity when idle
+    unsigned callsSinceLimitCheck; // Only used by the worker itself
+    char padding[64];
+
+    SearchCounters() : nodesCreated(0), nodesExpanded(0), prunedAtPush(0), prunedAtPop(0), prunedByCompaction(0), queueCompactions(0), incumbentUpdates(0), 
+        dominanceHits(0), dominanceMisses(0), dominanceEvictions(0), boundNanoseconds(0), cycleCheckNanoseconds(0), queueNanoseconds(0), expandingBound(std::numeric_limits<double>::infinity()), callsSinceLimitCheck(0) {}
+};
+
+/*
+    Adds the time from its construction to its destruction to one of the phase times of SearchCounters, if enabled.
+*/
+class PhaseTimer {
+public:
+    PhaseTimer(bool enabled, std::atomic<long long> &nanoseconds) : enabled(enabled), nanoseconds(nanoseconds)
+    {
+        if (enabled)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~PhaseTimer()
+    {
+        if (enabled)
+        {
+            addToCounter(nanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+private:
+    bool enabled;
+    std::atomic<long long> &nanoseconds;
+    std::chrono::steady_clock::time_point start;
+};
+
+// The counters of every worker added up, plus the state of the queues; see collectStatistics()
+struct SearchStatistics {
+    long long nodesCreated;
+    long long nodesExpanded;
+    long long prunedAtPush;
+    long long prunedAtPop;
+    long long prunedByCompaction;
+    long long queueCompactions;
+    long long incumbentUpdates;
+    long long dominanceHits;
+    long long dominanceMisses;
+    long long dominanceEvictions;
+    long long boundNanoseconds;
+    long long cycleCheckNanoseconds;
+    long long queueNanoseconds;
+    int queuedNodes; // Nodes queued or being expanded
+    int peakQueuedNodes;
+    double bestRouteCost; // Infinity until a route is found
+    double lowerBound; // Smallest bound of any node still to be searched, or bestRouteCost once none is left
+    double gap; // (bestRouteCost - lowerBound) / bestRouteCost; infinity until a route is found
+};
+
+// How the cost of an edge is derived from the city coordinates of a TSPLIB instance (EXPLICIT instances give the costs directly)
+enum EdgeWeightType { EXPLICIT_WEIGHTS, EUC_2D_WEIGHTS, CEIL_2D_WEIGHTS, ATT_WEIGHTS, GEO_WEIGHTS };
+
+// How a DistanceOracle holds the cost of each edge
+enum DistanceStorage { FULL_DISTANCES, TRIANGULAR_DISTANCES, NARROW_TRIANGULAR_DISTANCES, COORDINATE_DISTANCES };
+const char *const DISTANCE_STORAGE_NAMES[] = { "full matrix", "32-bit upper triangle", "16-bit upper triangle", "computed from the coordinates" };
+
+const char *traceEventToString(TraceEvent event);
+int coordinateDistance(const std::pair<double, double> &a, const std::pair<double, double> &b, EdgeWeightType type);
+uint64_t subsetRank(RowMask subset);
+RowMask subsetOfRank(uint64_t rank, int size);
+struct WorkerQueue;
+struct RemoteWorker;
+struct WorkerInbox;
+class MessageSocket;
+
+// Compares the lower bounds of two nodes, returns true if p1.lB > p2.lB. Used as comparison function for priority queue.
+struct Comparator {
+    bool operator()(node const& p1, node const& p2)
+    {        
+        return p1.lowerBound > p2.lowerBound;
+    }
+};
+
+/*
+    Priority_Queue is a container adapter in the C++ standard library. The first parameter "node" specifies the type being stored.
+    The second parameter vector<node> specifies how to store that type, which in this case is a vector of nodes. The third parameter 
+    specifies the comparison function which determines how the nodes are stored. The comparator above is used as this function.
+
+    The adapter hides its vector; nodes() gives read access to it, in heap order, so that a checkpoint can save every queued node, and 
+    removeBoundedBy() drops every node that can no longer beat a route in one pass, wherever it sits in the heap.
+*/
+class NodeQueue : public std::priority_queue<node, std::vector<node>, Comparator> {
+public:
+    const std::vector<node> &nodes() const { return c; }
+
+    /*
+        Hands every node whose lowerBound is at least cutoff to discard and removes it, then rebuilds the heap from the nodes left (make_heap 
+        is linear, where popping the nodes one by one would cost a log each). Memory left over by a large removal is given back. Returns the
+        number of nodes removed.
+    */
+    template <typename Discard> size_t removeBoundedBy(double cutoff, Discard discard)
+    {
+        std::vector<node>::iterator removed = std::partition(c.begin(), c.end(), [cutoff](const node &nodeX) { return nodeX.lowerBound < cutoff; });
+        size_t numberRemoved = c.end() - removed;
+        std::for_each(removed, c.end(), discard);
+        c.erase(removed, c.end());
+        std::make_heap(c.begin(), c.end(), comp);
+        if (c.size() < c.capacity() / 4)
+        {
+            c.shrink_to_fit();
+        }
+        return numberRemoved;
+    }
+};
+
+/*
+    Each worker thread owns one of these. The worker pops and pushes its own queue; when it runs dry it steals the best node from
+    another worker's queue. The mutex guards the queue against those steals.
+*/
+struct WorkerQueue {
+    std::mutex queueMutex;
+    NodeQueue unprocessedNodesQueue; // Contains nodes that can still be expanded (not complete routes)
+    double compactedAtCost; // Best route cost when the queue was last compacted (see pruneNodesUpdated()); infinity before the first compaction
+
+    WorkerQueue() : compactedAtCost(std::numeric_limits<double>::infinity()) {}
+};
+
+/*
+    The cost of every edge of an instance (the adjacencyMatrix). The exact engines scan whole rows, so their instances (at most MAX_CITIES 
+    cities) are kept as one contiguous row-major block, and operator[] gives a row: [a][b] is the cost from a to b. Larger instances, which 
+    only the Lin-Kernighan engine takes, are read through distance(). Explicit costs are then packed as the upper triangle (the solver 
+    charges every edge by it, see symmetrizeAdjacencyMatrix()) in 16 bits, widened to 32 bits by the first cost that does not fit; the 
+    costs of a coordinate instance are computed from the coordinates each time they are asked for. Memory grows with the upper triangle 
+    (N^2 bytes at 16 bits) or with the number of cities, rather than with N^2 ints spread over N allocations.
+*/
+class DistanceOracle {
+public:
+    DistanceOracle() : storage(FULL_DISTANCES), numberOfCities(0), coordinates(NULL), weightType(EXPLICIT_WEIGHTS) {}
+    void assign(int cities, DistanceStorage storageKind = FULL_DISTANCES);
+    void assign(const std::vector<std::vector<int> > &rows);
+    void useCoordinates(const std::vector<std::pair<double, double> > *cityCoordinates, EdgeWeightType type);
+    void set(int from, int to, int cost);
+    void clear() { assign(0); }
+    bool empty() const { return numberOfCities == 0; }
+    int size() const { return numberOfCities; }
+    DistanceStorage storageKind() const { return storage; }
+    size_t bytes() const { return full.size() * sizeof(int) + triangle.size() * sizeof(int) + narrowTriangle.size() * sizeof(uint16_t); }
+
+    // Rows only exist with FULL_DISTANCES
+    int *operator[](int row) { return &full[size_t(row) * numberOfCities]; }
+    const int *operator[](int row) const { return &full[size_t(row) * numberOfCities]; }
+
+    int distance(int from, int to) const
+    {
+        switch (storage)
+        {
+            case FULL_DISTANCES:
+                return full[size_t(from) * numberOfCities + to];
+            case COORDINATE_DISTANCES:
+                return coordinateDistance((*coordinates)[from], (*coordinates)[to], weightType);
+            default:
+                if (from == to)
+                {
+                    return 0;
+                }
+                size_t index = from < to ? triangleIndex(from, to) : triangleIndex(to, from);
+                return storage == NARROW_TRIANGULAR_DISTANCES ? narrowTriangle[index] : triangle[index];
+        }
+    }
+
+private:
+    size_t triangleIndex(int from, int to) const { return size_t(from) * (2 * size_t(numberOfCities) - from - 1) / 2 + (to - from - 1); } // from < to
+
+    DistanceStorage storage;
+    int numberOfCities;
+    std::vector<int> full; // numberOfCities x numberOfCities, row by row
+    std::vector<int> triangle; // Edges from < to, row by row; the diagonal is not stored
+    std::vector<uint16_t> narrowTriangle; // The same, while every cost fits in 16 bits
+    const std::vector<std::pair<double, double> > *coordinates;
+    EdgeWeightType weightType;
+};
+
+/*
+    Bounded table of the partial routes the branch-and-bound search has seen, used to drop a node that a cheaper one dominates. Two nodes 
+    with the same signature (the same cities given both their edges, the same fragment ends paired the same way, and the same edges excluded
+    between the cities that can still be given one) can be completed by exactly the same edges, so the one whose included edges cost more
+    cannot lead to a better route and is dropped (see dominatedByCheaperNode()). The table is a fixed array of buckets of 
+    DOMINANCE_CACHE_WAYS entries, each keyed by a 64-bit signature and 32 bits of a second, independent hash that must match too; a full bucket
+    evicts its most expensive entry. The buckets are shared by every worker, under DOMINANCE_CACHE_LOCKS striped mutexes. Losing an entry 
+    only costs a pruning opportunity, never a route.
+*/
+class DominanceCache {
+public:
+    DominanceCache() : numberOfBuckets(0), firstBucket(NULL) {}
+    void reset(long long bytes);
+    bool enabled() const { return numberOfBuckets != 0; }
+    bool dominated(uint64_t signature, uint64_t check, long long cost, bool &evicted);
+
+private:
+    struct Entry {
+        uint64_t signature; // 0 for an empty entry
+        uint32_t check;
+        int cost; // Cost of the included edges of the cheapest node seen with this signature
+    };
+    struct FreeEntries {
+        void operator()(Entry *entries) const { std::free(entries); }
+    };
+
+    std::unique_ptr<Entry, FreeEntries> entries; // (numberOfBuckets + 1) * DOMINANCE_CACHE_WAYS, from calloc()
+    size_t numberOfBuckets; // A power of two
+    Entry *firstBucket; // The first entry of entries that starts a cache line
+    std::mutex locks[DOMINANCE_CACHE_LOCKS];
+};
+
+struct ProgramVariables {
+    std::vector<std::unique_ptr<WorkerQueue> > workerQueues; // One queue per worker thread
+    std::atomic<int> outstandingNodes; // Nodes sitting in a queue or being expanded; the search is over when this reaches 0
+    std::atomic<int> peakOutstandingNodes; // Highest value outstandingNodes reached, reported by the benchmark as the peak queue size
+    DistanceOracle adjacencyMatrix; // Cost of each edge; for up to MAX_CITIES cities a 2D matrix where [a][b] = cost from a->b, b->a
+    NodeArena nodeArena; // Holds the configurationMatrix of every node in the queues
+    std::mutex routeMutex; // Guards foundRoute
+    node foundRoute; // Keeps its arena block for as long as it is the best route
+    std::atomic<double> bestRouteCost; // Cost of foundRoute, readable without taking routeMutex; infinity until a route is found
+    std::atomic<bool> endProgram; 
+    int numberOfCitiesToVisit;
+    int numberOfThreads; // Number of worker threads expanding nodes
+    std::string instancePath; // Instance file given with --instance; empty when a built-in simulation is used
+    int simulationMode; // Built-in simulation given with --simulation (5, 6 or 7); 0 to ask interactively
+    std::string batchPath; // Manifest given with --batch; empty to solve a single instance
+    EdgeWeightType edgeWeightType; // How adjacencyMatrix is filled from cityCoordinates
+    std::vector<std::pair<double, double> > cityCoordinates; // Coordinates of each city; empty for instances that list their costs explicitly
+    BoundType boundType; // Which lower bound nodes are given
+    SolverEngine engine; // Engine requested with --engine
+    SolverEngine engineUsed; // Engine that solved the current instance (never AUTO_ENGINE once solveLoadedInstance() has chosen)
+    int restarts; // Tours the Lin-Kernighan engine builds and improves (--restarts); 0 for one per thread
+    unsigned seed; // First random seed of the Lin-Kernighan restarts (--seed); restart r uses seed + r
+    std::vector<int> heuristicRoute; // Best tour of the Lin-Kernighan engine, in tour order; foundRoute is not used by that engine
+    std::vector<std::pair<double, double> > routeHistory; // Time (ms from solveStartTime) and cost of each improvement of heuristicRoute
+    int restartsCompleted; // Lin-Kernighan restarts that ran to a local optimum before the time limit
+    SearchMode searchMode; // How the branch-and-bound engine orders its nodes
+    BranchingStrategy branchingStrategy; // How the branch-and-bound engine picks the edge each node branches on
+    long long memoryBudget; // Bytes of queued nodes from which the hybrid search turns depth-first (--memory-budget, in MB)
+    ExpansionMode expansionMode; // Whether a popped node branches on one edge or on every edge left in its row (row-major branching only)
+    long long dominanceCacheBytes; // Size of the dominanceCache (--dominance-cache, in MB); 0 turns it off
+    DominanceCache dominanceCache;
+    std::vector<DepthFirstStack> depthFirstStacks; // One per worker, reused by every depth-first search the worker runs
+    bool warmStart; // Seed foundRoute with a heuristic route before the search (disabled with --no-warm-start)
+    std::atomic<long long> nodesExpanded; // Number of nodes popped and expanded (states filled by the Held-Karp engine, improving moves made by the Lin-Kernighan engine), reported at the end to compare bounds
+    std::vector<std::unique_ptr<SearchCounters> > searchCounters; // One per worker; nodesExpanded is their total once the search is over
+    bool timeSearchPhases; // Measure the phase times of searchCounters (set by --stats)
+    double progressSeconds; // Interval of the progress line (--progress); 0 for none
+    double timeLimitSeconds; // Wall time allowed from the start of solveLoadedInstance() (--time-limit); 0 for none
+    long long nodeLimit; // Nodes the search may expand (--node-limit); 0 for none
+    std::atomic<bool> stoppedByLimit; // Set when a limit ended the search; foundRoute is then the best route found, not a proven optimum
+    double provenLowerBound; // No route costs less than this: the smallest bound left unsearched, or the route's cost once it is proven optimal
+    std::string statisticsPath; // Where the statistics report is written (--stats); empty for none
+    std::mutex progressMutex; // Lets the end of the search wake the progress thread
+    std::condition_variable progressCondition;
+    std::string checkpointPath; // Where the search is saved every checkpointSeconds and when it ends (--checkpoint); empty for none
+    double checkpointSeconds; // Interval between two checkpoints (--checkpoint-interval)
+    std::string resumePath; // Checkpoint the search is resumed from instead of the root (--resume); empty for none
+    std::atomic<bool> checkpointRequested; // Set while the checkpoint thread waits for the workers to pause
+    int runningWorkers; // Workers still in workerLoop(); guarded by checkpointMutex
+    int pausedWorkers; // Workers paused for the current checkpoint; guarded by checkpointMutex
+    std::mutex checkpointMutex; // Lets the checkpoint thread and the workers wait for each other
+    std::condition_variable checkpointCondition;
+    long long nodesExpandedBeforeResume; // Nodes the checkpoint given with --resume had expanded, carried into the next checkpoints
+    double millisecondsBeforeResume; // Search time of the checkpoint given with --resume, likewise
+    std::string listenAddress; // Where the coordinator of a distributed search waits for its workers (--listen); empty for a local search
+    int workerProcesses; // Worker processes the coordinator waits for (--workers)
+    std::string coordinatorAddress; // Coordinator this process works for (--connect); empty for a local search
+    MessageSocket *coordinatorConnection; // Set in a worker process while it is connected; routes found are sent through it
+    LogLevel logLevel; // Summary by default: results and totals on the console, no per-node output
+    std::string traceLogPath; // Where the trace is written at LOG_TRACE
+    TraceLog traceLog;
+    std::chrono::steady_clock::time_point solveStartTime; // Set by solveLoadedInstance(); the times below are measured from it
+    double firstRouteMilliseconds; // When the first route (heuristic or searched) was recorded; negative until then
+    double bestRouteMilliseconds; // When the current foundRoute was recorded
+    double searchMilliseconds; // Wall time of nodeExpansionDispatcher()
+    double solveMilliseconds; // Until foundRoute was proven optimal (root bound, starting route and search)
+
+    ProgramVariables() : outstandingNodes(0), peakOutstandingNodes(0), bestRouteCost(std::numeric_limits<double>::infinity()), endProgram(false), numberOfCitiesToVisit(0), numberOfThreads(1), 
+        simulationMode(0), edgeWeightType(EXPLICIT_WEIGHTS), boundType(SIMPLE_BOUND), engine(AUTO_ENGINE), engineUsed(BRANCH_AND_BOUND_ENGINE), restarts(0), seed(1), restartsCompleted(0), 
+        searchMode(BEST_FIRST_SEARCH), branchingStrategy(ROW_MAJOR_BRANCHING), memoryBudget(DEFAULT_MEMORY_BUDGET_MB << 20), expansionMode(EDGE_EXPANSION), dominanceCacheBytes(0), warmStart(true), nodesExpanded(0), 
+        timeSearchPhases(false), progressSeconds(0), timeLimitSeconds(0), nodeLimit(0), stoppedByLimit(false), 
+        provenLowerBound(std::numeric_limits<double>::infinity()), checkpointSeconds(DEFAULT_CHECKPOINT_SECONDS), checkpointRequested(false), 
+        runningWorkers(0), pausedWorkers(0), nodesExpandedBeforeResume(0), millisecondsBeforeResume(0), workerProcesses(1), coordinatorConnection(NULL), logLevel(LOG_SUMMARY), traceLogPath("tsp_trace.log"), firstRouteMilliseconds(-1), bestRouteMilliseconds(-1), searchMilliseconds(0), solveMilliseconds(0)
+    {
+        foundRoute.lowerBound = std::numeric_limits<double>::infinity();
+    }
+};
+
+/*
+    One branch-and-bound / Held-Karp solver. Everything a solve touches lives in its programVariables, so any number of solvers can run in 
+    the same process at the same time (the batch mode of TravelingSalesmanParallel.cpp runs one per pool thread). An instance is loaded with
+    loadInstanceFile() or setAdjacencyMatrix() (or written into programVariables directly), solved with solveLoadedInstance() and read back 
+    from programVariables, bestRoute() or printSearchResults(). resetProgramVariables() readies the solver for the next instance.
+    solveAsCoordinator() and solveAsWorker() spread one search over several processes instead.
+*/
+class TravelingSalesmanSolver {
+public:
+    ProgramVariables programVariables; // Options, instance and results of this solver
+
+    bool solveLoadedInstance();
+    bool solveAsCoordinator();
+    bool solveAsWorker();
+    void resetProgramVariables();
+    void printSearchResults();
+    std::vector<int> bestRoute();
+    SearchStatistics collectStatistics();
+    ExpansionMode expansionModeUsed();
+    bool writeStatisticsReport(const std::string &path);
+    void setAdjacencyMatrix();
+    bool loadInstanceFile(const std::string &path);
+
+private:
+    Configuration configurationOf(const node &nodeX);
+    node cloneNode(const node &nodeX, int id);
+    node initializeConfigurationMatrix();
+    void buildAdjacencyMatrixFromCoordinates();
+    void sizeNodeArena();
+    void createWorkerQueues();
+    void nodeExpansionDispatcher();
+    void heldKarpDispatcher();
+    template <typename Cost> void solveWithHeldKarp();
+    template <typename Entry> void dispatchSmallHeldKarp();
+    template <typename Entry, int N> void solveWithSmallHeldKarp();
+    template <typename Cost> void fillHeldKarpLayer(int layer, uint64_t firstRank, uint64_t lastRank, const std::vector<Cost> &distances, 
+        const std::vector<Cost> &previousLayer, std::vector<Cost> &currentLayer, uint8_t *parents);
+    void workerLoop(int id);
+    bool searchLimitReached(int id);
+    void progressLoop();
+    void printProgressLine(double seconds);
+    void checkpointLoop();
+    void pauseForCheckpoint();
+    uint64_t serializeCheckpoint(std::vector<unsigned char> &buffer);
+    bool writeCheckpointFile(const std::vector<unsigned char> &buffer);
+    bool resumeFromCheckpoint(const std::string &path);
+    void appendNodeRecord(std::vector<unsigned char> &buffer, const node &nodeX);
+    bool readNodeRecord(const unsigned char *position, node &nodeX, int id);
+    uint64_t adjacencyMatrixHash();
+    bool brokerSubproblems(std::vector<std::unique_ptr<RemoteWorker> > &workers);
+    bool handOutSubproblems(std::vector<std::unique_ptr<RemoteWorker> > &workers, size_t &nextStealTarget);
+    void workerReceiveLoop(MessageSocket *connection, WorkerInbox *inbox);
+    std::vector<unsigned char> giveUpQueuedNodes(int id);
+    void recordRemoteRoute(node &nodeX, int id);
+    bool acquireUnprocessedNode(int id, node &nodeX);
+    void pushUnprocessedNode(node &nodeX, int id);
+    void pushUnprocessedNodes(node *nodes, int numberOfNodes, int id);
+    void expandNode(node &nodeX, int id);
+    void expandRow(node &nodeX, int id);
+    void updateFoundRoute(node &nodeX, int id);
+    bool shouldSearchDepthFirst();
+    void searchDepthFirst(node &nodeX, int id);
+    void enterDepthFirstNode(node &nodeX, DepthFirstStack &stack, int id);
+    void applyDepthFirstChild(node &nodeX, DepthFirstStack &stack, bool include, int id);
+    void undoDepthFirstChild(node &nodeX, DepthFirstStack &stack);
+    void spillDepthFirstStack(node &nodeX, DepthFirstStack &stack, int id);
+    void undoModifyMatrix(node &nodeX, bool include, const MatrixChange &change);
+    bool updateNodeConstraint(node &node, int id);
+    bool chooseBranchingEdge(node &nodeX, int id);
+    int scoreExclusionPenalties(const Configuration &configuration, const RowMask *undecided, BranchingCandidate *candidates);
+    double evaluateBranchingChild(node &nodeX, bool include, int id);
+    void setNodeFlags(node &node, int id);
+    bool checkForCycles(const node &nodeX);
+    void checkInclude(node &nodeX, int id);
+    void checkExclude(node &nodeX, int id);
+    bool boundChild(node &nodeX, bool include, int id);
+    bool dominatedByCheaperNode(const node &nodeX, int id);
+    MatrixChange modifyMatrix(node &node, bool include);
+    void calculateLowerBoundForNode(node &nodeX);
+    void calculateLowerBoundForNodeUpdated(node &nodeX, const MatrixChange &change); 
+    int calculateRowLowerBound(const Configuration &configuration, int row);
+    void calculateOneTreeBound(node &nodeX, int iterations, int id);
+    double calculateOneTree(const Configuration &configuration, const double *penalties, int *degrees, int *treeNeighbour);
+    void recordOneTreeRoute(node &nodeX, const int *treeNeighbour, int id);
+    node createRouteNode(const std::pair<int, int> *edges, int id);
+    void seedFoundRouteWithHeuristic();
+    std::vector<std::vector<int> > buildNeighbourLists(int size);
+    std::vector<int> nearestNeighbourTour();
+    int calculateTourCost(const std::vector<int> &tour);
+    bool improveTourWithTwoOpt(std::vector<int> &tour, const std::vector<std::vector<int> > &neighbours);
+    bool improveTourWithOrOpt(std::vector<int> &tour, const std::vector<std::vector<int> > &neighbours);
+    void linKernighanDispatcher();
+    void linKernighanWorker(int id, const std::vector<int> &candidates, const CityTree &cityTree, std::atomic<int> &nextRestart, int restarts);
+    int cityDistance(int from, int to);
+    std::vector<int> buildCandidateLists(const CityTree &cityTree);
+    void buildNearestNeighbourTour(LocalSearchTour &tour, int start, CityTree &cityTree);
+    void applyTwoOptMove(LocalSearchTour &tour, int a, int b, int c);
+    bool improveCityWithLinKernighan(LocalSearchTour &tour, int city, const std::vector<int> &candidates);
+    int chooseLinKernighanSteps(const LocalSearchTour &tour, int t1, int t2, long long gain, const std::vector<int> &candidates, 
+        std::pair<long long, int> *steps, int capacity);
+    bool improveCityWithOrOpt(LocalSearchTour &tour, int city, const std::vector<int> &candidates);
+    void activateCities(LocalSearchTour &tour, const int *cities, int count);
+    bool optimizeTourLocally(LocalSearchTour &tour, const std::vector<int> &candidates, int id);
+    void offerLocalSearchTour(const LocalSearchTour &tour, int id);
+    bool heuristicTimeLimitReached();
+    void symmetrizeAdjacencyMatrix();
+    void pruneNodesUpdated(WorkerQueue &workerQueue, int id);
+    void print(const node &nodeX);
+    void printBestRoute();
+};
+
+#endif